@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+    Purpose: Streaming Daemon entry point
+
+    Usage: MyPlugInDaemon [--input <endpoint>] [--output <endpoint>] [--control <endpoint>]
+                          [--channels <1|2>] [--block <frames>] [--ring <frames>]
+                          [--report <seconds>]
+
+    Endpoints are "stdin", "stdout", "fifo:<path>" or "unix:<path>".
+    Example: MyPlugInDaemon --input unix:/tmp/flanger.sock --control fifo:/tmp/flanger.ctl
+
+  ==============================================================================
+*/
+
+#include "StreamingDaemon.h"
+
+#include <csignal>
+#include <iostream>
+
+namespace
+{
+    StreamingDaemon* runningDaemon = nullptr;
+
+    void handleStopSignal(int)
+    {
+        if (runningDaemon != nullptr)
+            runningDaemon->stop();
+    }
+
+    void printUsage()
+    {
+        std::cerr << "Usage: MyPlugInDaemon [--input <endpoint>] [--output <endpoint>] [--control <endpoint>]" << std::endl
+                  << "                      [--channels <1|2>] [--block <frames>] [--ring <frames>] [--report <seconds>]" << std::endl
+                  << "Endpoints: stdin, stdout, fifo:<path>, unix:<path>" << std::endl
+                  << "Audio is interleaved 32-bit float at 48 kHz" << std::endl;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    StreamingDaemonOptions options;
+
+    for (int index = 1; index < argc; index++)
+    {
+        juce::String argument(argv[index]);
+        bool hasValue = index + 1 < argc;
+
+        if (argument == "--input" && hasValue)
+            options.input = argv[++index];
+        else if (argument == "--output" && hasValue)
+            options.output = argv[++index];
+        else if (argument == "--control" && hasValue)
+            options.control = argv[++index];
+        else if (argument == "--channels" && hasValue)
+            options.numChannels = juce::String(argv[++index]).getIntValue();
+        else if (argument == "--block" && hasValue)
+            options.blockSize = juce::String(argv[++index]).getIntValue();
+        else if (argument == "--ring" && hasValue)
+            options.ringFrames = juce::String(argv[++index]).getIntValue();
+        else if (argument == "--report" && hasValue)
+            options.reportIntervalSeconds = juce::String(argv[++index]).getDoubleValue();
+        else
+        {
+            printUsage();
+            return argument == "--help" ? 0 : 1;
+        }
+    }
+
+    StreamingDaemon daemon(options);
+    if (!daemon.open())
+        return 1;
+
+    // A reader going away must show up as a write error, not kill the process
+    std::signal(SIGPIPE, SIG_IGN);
+
+    runningDaemon = &daemon;
+    std::signal(SIGINT, handleStopSignal);
+    std::signal(SIGTERM, handleStopSignal);
+
+    int exitCode = daemon.run();
+    runningDaemon = nullptr;
+    return exitCode;
+}
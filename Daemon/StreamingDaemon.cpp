@@ -0,0 +1,577 @@
+/*
+  ==============================================================================
+    Purpose: Streaming Daemon
+
+    See StreamingDaemon.h for the endpoint formats.
+    Control channel commands are one per line: "<name> <value>", where name is one of
+    depth, rate, delay, phase, delaygain, regen, stages or spread (units as in ParameterId;
+    stages is the number of cascaded flanger stages, spread the cascade rate spread).
+    Lines whose value is not a number are rejected; the processor clamps values to its ranges.
+
+  ==============================================================================
+*/
+
+#include "StreamingDaemon.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+    // Sample rate the processor is designed for
+    const double daemonSampleRate = 48000.0;
+
+    void setNonBlocking(int fd)
+    {
+        int flags = fcntl(fd, F_GETFL, 0);
+        if (flags >= 0)
+            fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+
+    // Create the named pipe if needed and open it
+    // Opening read-write means the pipe never reports end of file when a writer goes away,
+    // and opening never blocks waiting for the other side
+    int openFifo(const juce::String& path)
+    {
+        if (mkfifo(path.toRawUTF8(), 0666) != 0 && errno != EEXIST)
+            return -1;
+
+        int fd = ::open(path.toRawUTF8(), O_RDWR | O_NONBLOCK);
+        return fd;
+    }
+
+    // Create a listening UNIX domain stream socket at path
+    int listenOnUnixSocket(const juce::String& path)
+    {
+        sockaddr_un address {};
+        if ((size_t)path.getNumBytesAsUTF8() >= sizeof(address.sun_path))
+            return -1;
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.toRawUTF8(), sizeof(address.sun_path) - 1);
+        unlink(path.toRawUTF8());
+
+        if (bind(fd, (sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 1) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+
+        return fd;
+    }
+
+    // Open stdin, stdout or a named pipe
+    int openStreamEndpoint(const juce::String& endpoint, bool forInput)
+    {
+        if (endpoint == "stdin" && forInput)
+            return STDIN_FILENO;
+        if (endpoint == "stdout" && !forInput)
+            return STDOUT_FILENO;
+        if (endpoint.startsWith("fifo:"))
+            return openFifo(endpoint.fromFirstOccurrenceOf("fifo:", false, false));
+
+        return -1;
+    }
+
+    // Wait up to timeoutMs for a connection on listenFd, returns the client or -1
+    int acceptWithTimeout(int listenFd, int timeoutMs)
+    {
+        pollfd waiting { listenFd, POLLIN, 0 };
+        if (poll(&waiting, 1, timeoutMs) <= 0)
+            return -1;
+
+        return accept(listenFd, nullptr, nullptr);
+    }
+}
+
+//==============================================================================
+/*
+Class: StreamingDaemon::ControlThread
+       Reads parameter commands from the control channel and hands them to the
+       processor through setParameterAsync, so the audio path never takes a lock
+*/
+class StreamingDaemon::ControlThread : public juce::Thread
+{
+public:
+    // Constructor
+    ControlThread(MyPlugInAudioProcessor& processorToControl, const juce::String& controlEndpoint)
+        : juce::Thread("Control Channel"), processor(processorToControl), endpoint(controlEndpoint)
+    {
+    };
+
+    void run() override
+    {
+        bool isSocket = endpoint.startsWith("unix:");
+        int listenFd = -1;
+        int fd = -1;
+
+        if (isSocket)
+            listenFd = listenOnUnixSocket(endpoint.fromFirstOccurrenceOf("unix:", false, false));
+        else
+            fd = openStreamEndpoint(endpoint, true);
+
+        if (fd < 0 && listenFd < 0)
+        {
+            std::cerr << "Could not open control channel " << endpoint << std::endl;
+            return;
+        }
+
+        juce::String line;
+        char data[256];
+
+        while (!threadShouldExit())
+        {
+            // Wait for the next controlling client
+            if (fd < 0)
+            {
+                fd = acceptWithTimeout(listenFd, 100);
+                continue;
+            }
+
+            pollfd reading { fd, POLLIN, 0 };
+            if (poll(&reading, 1, 100) <= 0)
+                continue;
+
+            ssize_t received = read(fd, data, sizeof(data));
+            if (received <= 0)
+            {
+                // Client went away, or a read error on the pipe
+                if (isSocket && received == 0)
+                {
+                    close(fd);
+                    fd = -1;
+                }
+                continue;
+            }
+
+            // Split the received bytes into command lines
+            for (ssize_t index = 0; index < received; index++)
+            {
+                if (data[index] == '\n')
+                {
+                    handleCommand(line);
+                    line.clear();
+                }
+                else
+                {
+                    line += data[index];
+                }
+            }
+        }
+
+        if (fd >= 0 && fd != STDIN_FILENO)
+            close(fd);
+        if (listenFd >= 0)
+            close(listenFd);
+    };
+
+private:
+    // Parse "<name> <value>" and queue the parameter change
+    void handleCommand(const juce::String& command)
+    {
+        auto tokens = juce::StringArray::fromTokens(command.trim(), false);
+        if (tokens.size() != 2)
+            return;
+
+        juce::String name = tokens[0].toLowerCase();
+        float value = 0.0f;
+        if (!parseValue(tokens[1], value))
+        {
+            std::cerr << "Invalid value in control command: " << command << std::endl;
+            return;
+        }
+
+        if (name == "depth")
+            processor.setParameterAsync(ParameterId::Depth, value);
+        else if (name == "rate")
+            processor.setParameterAsync(ParameterId::Rate, value);
+        else if (name == "delay")
+            processor.setParameterAsync(ParameterId::Delay, value);
+        else if (name == "phase")
+            processor.setParameterAsync(ParameterId::PhaseOffset, value);
+        else if (name == "delaygain")
+            processor.setParameterAsync(ParameterId::DelayGain, value);
+        else if (name == "regen")
+            processor.setParameterAsync(ParameterId::RegenGain, value);
+        else if (name == "stages")
+            processor.setParameterAsync(ParameterId::CascadeStages, value);
+        else if (name == "spread")
+            processor.setParameterAsync(ParameterId::CascadeRateSpread, value);
+        else
+            std::cerr << "Unknown control command: " << command << std::endl;
+    };
+
+    // Parse the whole of text as a finite number
+    // Unlike String::getFloatValue, text that isn't a number is an error rather than 0
+    static bool parseValue(const juce::String& text, float& value)
+    {
+        const char* start = text.toRawUTF8();
+        char* end = nullptr;
+        value = std::strtof(start, &end);
+
+        return end != start && *end == 0 && std::isfinite(value);
+    };
+
+    MyPlugInAudioProcessor& processor;
+    juce::String endpoint;
+};
+
+//==============================================================================
+StreamingDaemon::StreamingDaemon(const StreamingDaemonOptions& daemonOptions)
+    : options(daemonOptions)
+{
+}
+
+StreamingDaemon::~StreamingDaemon()
+{
+    if (controlThread != nullptr)
+        controlThread->stopThread(1000);
+
+    closeClient();
+
+    if (listenFd >= 0)
+        close(listenFd);
+}
+
+bool StreamingDaemon::open()
+{
+    if (options.numChannels < 1 || options.numChannels > 2)
+    {
+        std::cerr << "Only mono and stereo streams are supported" << std::endl;
+        return false;
+    }
+
+    if (options.blockSize < 1 || options.blockSize * 2 > options.ringFrames)
+    {
+        std::cerr << "The block size must be at least 1 and at most half the ring size" << std::endl;
+        return false;
+    }
+
+    // Allocate everything the streaming loop needs up front
+    frameBytes = options.numChannels * (int)sizeof(float);
+    inputRing.assign((size_t)(options.ringFrames * options.numChannels), 0.0f);
+    outputRing.assign((size_t)(options.ringFrames * options.numChannels), 0.0f);
+    inputFifo = std::make_unique<juce::AbstractFifo>(options.ringFrames);
+    outputFifo = std::make_unique<juce::AbstractFifo>(options.ringFrames);
+    // Enough for every block that can be waiting in the input and output rings at once
+    blockArrivals.assign((size_t)(2 * options.ringFrames / options.blockSize + 2), BlockArrival());
+    nextBlockEndFrame = framesQueued + options.blockSize;
+
+    planarChannels.assign((size_t)options.numChannels, std::vector<float>((size_t)options.blockSize, 0.0f));
+    planarPointers.clear();
+    for (auto& channel : planarChannels)
+        planarPointers.push_back(channel.data());
+
+    processor = std::make_unique<MyPlugInAudioProcessor>();
+    processor->setPlayConfigDetails(options.numChannels, options.numChannels, daemonSampleRate, options.blockSize);
+    processor->prepareToPlay(daemonSampleRate, options.blockSize);
+
+    // A UNIX socket carries both directions and is connected in run()
+    if (options.input.startsWith("unix:"))
+    {
+        inputIsSocket = true;
+        listenFd = listenOnUnixSocket(options.input.fromFirstOccurrenceOf("unix:", false, false));
+        if (listenFd < 0)
+        {
+            std::cerr << "Could not listen on " << options.input << std::endl;
+            return false;
+        }
+    }
+    else
+    {
+        inputIsStdin = options.input == "stdin";
+        inputFd = openStreamEndpoint(options.input, true);
+        outputFd = openStreamEndpoint(options.output, false);
+        if (inputFd < 0 || outputFd < 0)
+        {
+            std::cerr << "Could not open " << (inputFd < 0 ? options.input : options.output) << std::endl;
+            return false;
+        }
+
+        setNonBlocking(inputFd);
+        setNonBlocking(outputFd);
+    }
+
+    if (options.control.isNotEmpty())
+        controlThread = std::make_unique<ControlThread>(*processor, options.control);
+
+    return true;
+}
+
+void StreamingDaemon::stop()
+{
+    stopRequested = true;
+}
+
+//==============================================================================
+int StreamingDaemon::run()
+{
+    if (controlThread != nullptr)
+        controlThread->startThread();
+
+    if (inputIsSocket && !acceptClient())
+        return 0;
+
+    int exitCode = 0;
+    bool inputEnded = false;
+    double lastReportTime = juce::Time::getMillisecondCounterHiRes();
+
+    while (!stopRequested)
+    {
+        pollfd waiting[2];
+        int numWaiting = 0;
+
+        // Wait for input while there is room for it, and for the output while it is backed up
+        if (!inputEnded && inputFifo->getFreeSpace() > 0)
+            waiting[numWaiting++] = { inputFd, POLLIN, 0 };
+        if (outputFifo->getNumReady() > 0)
+            waiting[numWaiting++] = { outputFd, POLLOUT, 0 };
+
+        if (numWaiting == 0)
+        {
+            // Input has ended and all output has been sent
+            if (!inputIsSocket)
+                break;
+
+            // Serve the next client
+            closeClient();
+            if (!acceptClient())
+                break;
+            inputEnded = false;
+            continue;
+        }
+
+        if (poll(waiting, (nfds_t)numWaiting, 100) < 0 && errno != EINTR)
+        {
+            exitCode = 1;
+            break;
+        }
+
+        if (!inputEnded && !readInput())
+            inputEnded = true;
+
+        processAvailableBlocks(inputEnded);
+
+        if (outputFifo->getNumReady() > 0 && !writeOutput())
+        {
+            // The reader went away
+            if (!inputIsSocket)
+            {
+                exitCode = 1;
+                break;
+            }
+
+            inputEnded = true;
+            outputFifo->reset();
+            pendingOutputBytes = 0;
+        }
+
+        if (options.reportIntervalSeconds > 0.0
+            && juce::Time::getMillisecondCounterHiRes() - lastReportTime >= options.reportIntervalSeconds * 1000.0)
+        {
+            std::cerr << latencyHistogram.getSummary() << std::endl;
+            lastReportTime = juce::Time::getMillisecondCounterHiRes();
+        }
+    }
+
+    if (controlThread != nullptr)
+        controlThread->stopThread(1000);
+
+    std::cerr << latencyHistogram.getSummary() << std::endl;
+    return exitCode;
+}
+
+bool StreamingDaemon::acceptClient()
+{
+    while (!stopRequested)
+    {
+        int client = acceptWithTimeout(listenFd, 100);
+        if (client >= 0)
+        {
+            setNonBlocking(client);
+            inputFd = client;
+            outputFd = client;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void StreamingDaemon::closeClient()
+{
+    if (inputIsSocket && inputFd >= 0)
+        close(inputFd);
+
+    if (inputIsSocket)
+    {
+        inputFd = -1;
+        outputFd = -1;
+    }
+
+    // Anything not yet sent belonged to the previous client
+    if (inputFifo != nullptr)
+    {
+        inputFifo->reset();
+        outputFifo->reset();
+    }
+    pendingInputBytes = 0;
+    pendingOutputBytes = 0;
+    numArrivals = 0;
+    framesSent = framesQueued;
+    framesReceived = framesQueued;
+    nextBlockEndFrame = framesQueued + options.blockSize;
+}
+
+//==============================================================================
+// Read straight into the free part of the input ring
+bool StreamingDaemon::readInput()
+{
+    int start1, size1, start2, size2;
+    inputFifo->prepareToWrite(inputFifo->getFreeSpace(), start1, size1, start2, size2);
+    if (size1 == 0)
+        return true;
+
+    // Continue after any bytes of a partially received frame
+    char* destination = (char*)(inputRing.data() + start1 * options.numChannels) + pendingInputBytes;
+    size_t maxBytes = (size_t)(size1 * frameBytes - pendingInputBytes);
+
+    ssize_t received = read(inputFd, destination, maxBytes);
+    if (received == 0)
+        return false;
+    if (received < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+    lastInputTicks = juce::Time::getHighResolutionTicks();
+
+    // Only whole frames become readable, the rest stays pending at the ring position
+    int totalBytes = pendingInputBytes + (int)received;
+    inputFifo->finishedWrite(totalBytes / frameBytes);
+    pendingInputBytes = totalBytes % frameBytes;
+    framesReceived += totalBytes / frameBytes;
+
+    // This read completed the input of every block whose last frame it delivered
+    for (; nextBlockEndFrame <= framesReceived; nextBlockEndFrame += options.blockSize)
+        pushArrival(nextBlockEndFrame, lastInputTicks);
+
+    return true;
+}
+
+// Write straight from the filled part of the output ring until it is empty or the output is full
+bool StreamingDaemon::writeOutput()
+{
+    while (outputFifo->getNumReady() > 0)
+    {
+        int start1, size1, start2, size2;
+        outputFifo->prepareToRead(outputFifo->getNumReady(), start1, size1, start2, size2);
+
+        // Continue after any bytes of a partially sent frame
+        const char* source = (const char*)(outputRing.data() + start1 * options.numChannels) + pendingOutputBytes;
+        size_t numBytes = (size_t)(size1 * frameBytes - pendingOutputBytes);
+
+        ssize_t sent = write(outputFd, source, numBytes);
+        if (sent < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+        int totalBytes = pendingOutputBytes + (int)sent;
+        int framesDone = totalBytes / frameBytes;
+        outputFifo->finishedRead(framesDone);
+        pendingOutputBytes = totalBytes % frameBytes;
+        framesSent += framesDone;
+
+        recordSentBlocks();
+
+        if ((size_t)sent < numBytes)
+            break;
+    }
+
+    return true;
+}
+
+void StreamingDaemon::processAvailableBlocks(bool inputEnded)
+{
+    while (inputFifo->getNumReady() >= options.blockSize && outputFifo->getFreeSpace() >= options.blockSize)
+        processFrames(options.blockSize);
+
+    // Flush a final short block once no more input will arrive
+    int remaining = inputFifo->getNumReady();
+    if (inputEnded && remaining > 0 && remaining < options.blockSize && outputFifo->getFreeSpace() >= remaining)
+    {
+        // The last read completed this block too
+        pushArrival(framesReceived, lastInputTicks);
+        nextBlockEndFrame = framesReceived + options.blockSize;
+        processFrames(remaining);
+    }
+}
+
+void StreamingDaemon::processFrames(int numFrames)
+{
+    int numChannels = options.numChannels;
+    int start1, size1, start2, size2;
+
+    // Deinterleave from the input ring into the planar scratch
+    inputFifo->prepareToRead(numFrames, start1, size1, start2, size2);
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        float* planar = planarPointers[(size_t)channel];
+        for (int frame = 0; frame < size1; frame++)
+            planar[frame] = inputRing[(size_t)((start1 + frame) * numChannels + channel)];
+        for (int frame = 0; frame < size2; frame++)
+            planar[size1 + frame] = inputRing[(size_t)((start2 + frame) * numChannels + channel)];
+    }
+    inputFifo->finishedRead(size1 + size2);
+
+    // Refers to the preallocated scratch, so this does not allocate
+    juce::AudioBuffer<float> block(planarPointers.data(), numChannels, numFrames);
+    processor->processBlock(block, midiMessages);
+
+    // Interleave into the output ring
+    outputFifo->prepareToWrite(numFrames, start1, size1, start2, size2);
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        const float* planar = planarPointers[(size_t)channel];
+        for (int frame = 0; frame < size1; frame++)
+            outputRing[(size_t)((start1 + frame) * numChannels + channel)] = planar[frame];
+        for (int frame = 0; frame < size2; frame++)
+            outputRing[(size_t)((start2 + frame) * numChannels + channel)] = planar[size1 + frame];
+    }
+    outputFifo->finishedWrite(size1 + size2);
+    framesQueued += numFrames;
+}
+
+// Remember when the input of the block ending at endFrame was complete
+void StreamingDaemon::pushArrival(juce::int64 endFrame, juce::int64 arrivalTicks)
+{
+    if (numArrivals >= (int)blockArrivals.size())
+        return;
+
+    BlockArrival& arrival = blockArrivals[(size_t)((oldestArrival + numArrivals) % (int)blockArrivals.size())];
+    arrival.endFrame = endFrame;
+    arrival.arrivalTicks = arrivalTicks;
+    numArrivals++;
+}
+
+void StreamingDaemon::recordSentBlocks()
+{
+    juce::int64 now = juce::Time::getHighResolutionTicks();
+
+    while (numArrivals > 0 && blockArrivals[(size_t)oldestArrival].endFrame <= framesSent)
+    {
+        latencyHistogram.record(juce::Time::highResolutionTicksToSeconds(now - blockArrivals[(size_t)oldestArrival].arrivalTicks));
+        oldestArrival = (oldestArrival + 1) % (int)blockArrivals.size();
+        numArrivals--;
+    }
+}
@@ -0,0 +1,207 @@
+/*
+  ==============================================================================
+    Purpose: Streaming Daemon Header File
+
+    Runs the flanger as a long-lived local process.
+    Interleaved 32-bit float PCM at 48 kHz is read from stdin, a named pipe or a
+    UNIX domain socket, processed in small fixed blocks and written back out.
+    Parameter changes arrive as text lines on a separate control channel.
+
+    POSIX only. Build as a JUCE console application together with
+    ../Source/PluginProcessor.cpp and ../Source/PluginEditor.cpp.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "../Source/PluginProcessor.h"
+
+
+//==============================================================================
+/*
+    Endpoints are "stdin", "stdout", "fifo:<path>" or "unix:<path>"
+    A UNIX socket input is also used as the output, so output is ignored in that case
+*/
+struct StreamingDaemonOptions
+{
+    juce::String input = "stdin";
+    juce::String output = "stdout";
+    // Optional control channel, "fifo:<path>" or "unix:<path>"
+    juce::String control;
+    int numChannels = 2;
+    // Frames per processBlock call
+    int blockSize = 64;
+    // Capacity in frames of each of the input and output ring buffers
+    int ringFrames = 8192;
+    // Seconds between latency reports on stderr, 0 to only report on exit
+    double reportIntervalSeconds = 10.0;
+};
+
+/*
+Class: LatencyHistogram
+       Fixed-size histogram of latencies for percentile reporting
+       10 microsecond buckets up to one second, everything longer lands in the last bucket
+       Recording never allocates
+*/
+class LatencyHistogram
+{
+public:
+    // Constructor
+    LatencyHistogram()
+    {
+        buckets = std::vector<juce::uint32>(numBuckets, 0);
+    };
+
+    // Add one latency measurement in seconds
+    void record(double seconds)
+    {
+        int bucket = juce::jlimit(0, numBuckets - 1, (int)(seconds / bucketSeconds));
+        buckets[(size_t)bucket]++;
+        count++;
+        maximum = std::max(maximum, seconds);
+    };
+
+    // Return the latency in seconds below which percentile percent of the measurements fall
+    // Reported as the upper edge of the bucket, but never above the largest measurement
+    double getPercentile(double percentile)
+    {
+        if (count == 0)
+            return 0.0;
+
+        juce::int64 target = (juce::int64)std::ceil((double)count * percentile / 100.0);
+        juce::int64 seen = 0;
+        for (int bucket = 0; bucket < numBuckets; bucket++)
+        {
+            seen += buckets[(size_t)bucket];
+            if (seen >= target)
+                return juce::jmin((double)(bucket + 1) * bucketSeconds, maximum);
+        }
+
+        return maximum;
+    };
+
+    // Return a one-line summary in milliseconds
+    juce::String getSummary()
+    {
+        return "latency ms: p50 " + juce::String(getPercentile(50.0) * 1000.0, 3)
+             + " p90 " + juce::String(getPercentile(90.0) * 1000.0, 3)
+             + " p99 " + juce::String(getPercentile(99.0) * 1000.0, 3)
+             + " p99.9 " + juce::String(getPercentile(99.9) * 1000.0, 3)
+             + " max " + juce::String(maximum * 1000.0, 3)
+             + " (" + juce::String(count) + " blocks)";
+    };
+
+    juce::int64 getCount()
+    {
+        return count;
+    };
+
+private:
+    static constexpr int numBuckets = 100000;
+    static constexpr double bucketSeconds = 0.00001;
+    std::vector<juce::uint32> buckets;
+    juce::int64 count = 0;
+    double maximum = 0.0;
+};
+
+/*
+Class: StreamingDaemon
+       Single I/O and processing thread driven by poll()
+       Input and output go through preallocated ring buffers: read() and write() work
+       directly on the ring memory, and nothing is allocated once open() has succeeded
+       End-to-end latency is measured per block, from the read() that completed the block's
+       input to the write() that sent its last frame
+*/
+class StreamingDaemon
+{
+public:
+    StreamingDaemon(const StreamingDaemonOptions& options);
+    ~StreamingDaemon();
+
+    // Open the endpoints and prepare the processor, returns false on failure
+    bool open();
+
+    // Stream until stop() is called or stdin reaches end of file
+    // Returns the process exit code
+    int run();
+
+    // Ask run() to return, safe to call from a signal handler
+    void stop();
+
+    // Latency measurements so far
+    LatencyHistogram& getLatencyHistogram()
+    {
+        return latencyHistogram;
+    };
+
+private:
+    class ControlThread;
+
+    // Block record used to match output frames back to the time their input arrived
+    struct BlockArrival
+    {
+        juce::int64 endFrame = 0;
+        juce::int64 arrivalTicks = 0;
+    };
+
+    // Wait for the next client on the listening socket, returns false if stopped
+    bool acceptClient();
+    // Read as much input as fits into the input ring, returns false at end of file
+    bool readInput();
+    // Write as much of the output ring as the output accepts, returns false on error
+    bool writeOutput();
+    // Process every full block in the input ring (and a final short block once input has ended)
+    void processAvailableBlocks(bool inputEnded);
+    // Process numFrames frames from the input ring into the output ring
+    void processFrames(int numFrames);
+    // Queue the arrival time of the block whose input ends at endFrame
+    void pushArrival(juce::int64 endFrame, juce::int64 arrivalTicks);
+    // Record latencies of blocks whose output has been sent completely
+    void recordSentBlocks();
+    void closeClient();
+
+    StreamingDaemonOptions options;
+    std::unique_ptr<MyPlugInAudioProcessor> processor;
+    std::unique_ptr<ControlThread> controlThread;
+    std::atomic<bool> stopRequested { false };
+
+    int inputFd = -1;
+    int outputFd = -1;
+    int listenFd = -1;
+    bool inputIsStdin = false;
+    bool inputIsSocket = false;
+    int frameBytes = 0;
+
+    // Interleaved ring buffers, indexed in frames by the fifos
+    std::vector<float> inputRing;
+    std::vector<float> outputRing;
+    std::unique_ptr<juce::AbstractFifo> inputFifo;
+    std::unique_ptr<juce::AbstractFifo> outputFifo;
+    // Bytes of a partially received or sent frame at the ring position
+    int pendingInputBytes = 0;
+    int pendingOutputBytes = 0;
+
+    // Planar scratch handed to processBlock
+    std::vector<std::vector<float>> planarChannels;
+    std::vector<float*> planarPointers;
+    juce::MidiBuffer midiMessages;
+
+    // Arrival time bookkeeping for latency measurement
+    std::vector<BlockArrival> blockArrivals;
+    int oldestArrival = 0;
+    int numArrivals = 0;
+    juce::int64 lastInputTicks = 0;
+    // Input frames received so far and the frame at which the next block's input is complete
+    juce::int64 framesReceived = 0;
+    juce::int64 nextBlockEndFrame = 0;
+    juce::int64 framesQueued = 0;
+    juce::int64 framesSent = 0;
+    LatencyHistogram latencyHistogram;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StreamingDaemon)
+};
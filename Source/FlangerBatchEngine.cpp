@@ -0,0 +1,250 @@
+/*
+  ==============================================================================
+    Purpose: Batch Flanger Engine
+
+    Per-lane loops in processFrame are kept free of branches and of dependencies
+    between lanes so the compiler can vectorise them across streams.
+
+  ==============================================================================
+*/
+
+#include "FlangerBatchEngine.h"
+
+//==============================================================================
+void FlangerBatchEngine::prepare(int newNumStreams, int numChannelsPerStream, double sampleRate)
+{
+    numStreams = newNumStreams;
+    channelsPerStream = numChannelsPerStream;
+    numLanes = numStreams * channelsPerStream;
+    currentSampleRate = sampleRate;
+    framesSinceNormalise = 0;
+
+    streamSettings.assign((size_t)numStreams, FlangerSettings());
+
+    writeHeads.assign((size_t)numLanes, 0);
+    lfoCos.assign((size_t)numLanes, 1.0f);
+    lfoSin.assign((size_t)numLanes, 0.0f);
+    lfoStepCos.assign((size_t)numLanes, 1.0f);
+    lfoStepSin.assign((size_t)numLanes, 0.0f);
+    delayMinimums.assign((size_t)numLanes, 0.0f);
+    depthSamples.assign((size_t)numLanes, 0.0f);
+    dryGains.assign((size_t)numLanes, 0.0f);
+    wetGains.assign((size_t)numLanes, 0.0f);
+    regenDryGains.assign((size_t)numLanes, 0.0f);
+    regenWetGains.assign((size_t)numLanes, 0.0f);
+
+    laneSamples.assign((size_t)numLanes, 0.0f);
+    laneDelayed.assign((size_t)numLanes, 0.0f);
+    laneRegen.assign((size_t)numLanes, 0.0f);
+
+    delayLines.assign((size_t)numLanes * (size_t)lineLength, 0.0f);
+
+    // Start every stream from the default settings
+    for (int stream = 0; stream < numStreams; stream++)
+        setStreamSettings(stream, FlangerSettings());
+
+    resetStatistics();
+}
+
+void FlangerBatchEngine::setStreamSettings(int streamIndex, const FlangerSettings& settings)
+{
+    jassert(streamIndex >= 0 && streamIndex < numStreams);
+
+    FlangerSettings& previous = streamSettings[(size_t)streamIndex];
+
+    // Convert the vibrato's frequency ratio into a number of samples, as the processor does
+    float depth = (float)currentSampleRate * ((settings.f_ratio - 1.0f) / (float)(2.0f * M_PI * settings.lfoFrequency));
+    // Keep the longest delay (plus the interpolation neighbour) inside the delay line
+    float delayMinimum = juce::jlimit(1.0f, (float)(lineLength - 2), (float)settings.delayMinimum);
+    depth = juce::jlimit(0.0f, (float)(lineLength - 2) - delayMinimum, depth);
+
+    double phaseStep = 2.0 * M_PI * (double)settings.lfoFrequency / currentSampleRate;
+    float offsetChange = settings.phaseOffset - previous.phaseOffset;
+
+    for (int channel = 0; channel < channelsPerStream; channel++)
+    {
+        int lane = streamIndex * channelsPerStream + channel;
+
+        delayMinimums[(size_t)lane] = delayMinimum;
+        depthSamples[(size_t)lane] = depth;
+        dryGains[(size_t)lane] = 1.0f - settings.delayGain;
+        wetGains[(size_t)lane] = settings.delayGain;
+        regenDryGains[(size_t)lane] = 1.0f - settings.regenGain;
+        regenWetGains[(size_t)lane] = settings.regenGain;
+        lfoStepCos[(size_t)lane] = (float)cos(phaseStep);
+        lfoStepSin[(size_t)lane] = (float)sin(phaseStep);
+
+        // Rotate the phasor of every channel after the first by the change in phase offset
+        if (channel > 0 && offsetChange != 0.0f)
+        {
+            float c = lfoCos[(size_t)lane];
+            float s = lfoSin[(size_t)lane];
+            lfoCos[(size_t)lane] = c * cosf(offsetChange) - s * sinf(offsetChange);
+            lfoSin[(size_t)lane] = c * sinf(offsetChange) + s * cosf(offsetChange);
+        }
+    }
+
+    previous = settings;
+}
+
+//==============================================================================
+void FlangerBatchEngine::processBatch(FlangerStream* streams, int numBatchStreams)
+{
+    auto startTicks = juce::Time::getHighResolutionTicks();
+
+    numBatchStreams = juce::jmin(numBatchStreams, numStreams);
+    if (numBatchStreams <= 0)
+        return;
+
+    int batchLanes = numBatchStreams * channelsPerStream;
+    int commonFrames = streams[0].numFrames;
+    double laneFrames = 0.0;
+    for (int stream = 0; stream < numBatchStreams; stream++)
+    {
+        commonFrames = juce::jmin(commonFrames, streams[stream].numFrames);
+        laneFrames += (double)streams[stream].numFrames * (double)channelsPerStream;
+    }
+
+    // Frames every stream has: advance all lanes in lockstep
+    for (int frame = 0; frame < commonFrames; frame++)
+    {
+        for (int stream = 0; stream < numBatchStreams; stream++)
+            for (int channel = 0; channel < channelsPerStream; channel++)
+                laneSamples[(size_t)(stream * channelsPerStream + channel)] = streams[stream].channels[channel][frame];
+
+        processFrame(0, batchLanes);
+
+        for (int stream = 0; stream < numBatchStreams; stream++)
+            for (int channel = 0; channel < channelsPerStream; channel++)
+                streams[stream].channels[channel][frame] = laneSamples[(size_t)(stream * channelsPerStream + channel)];
+
+        if (++framesSinceNormalise >= normaliseInterval)
+            normaliseLFOs();
+    }
+
+    // Remaining frames of longer streams, one stream's lanes at a time
+    for (int stream = 0; stream < numBatchStreams; stream++)
+    {
+        int firstLane = stream * channelsPerStream;
+
+        for (int frame = commonFrames; frame < streams[stream].numFrames; frame++)
+        {
+            for (int channel = 0; channel < channelsPerStream; channel++)
+                laneSamples[(size_t)(firstLane + channel)] = streams[stream].channels[channel][frame];
+
+            processFrame(firstLane, firstLane + channelsPerStream);
+
+            for (int channel = 0; channel < channelsPerStream; channel++)
+                streams[stream].channels[channel][frame] = laneSamples[(size_t)(firstLane + channel)];
+        }
+    }
+
+    // Lanes that ran extra frames have drifted further than the lockstep interval allows for
+    if (commonFrames < laneFrames / (double)batchLanes)
+        normaliseLFOs();
+
+    processedLaneFrames += laneFrames;
+    processingSeconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+}
+
+// Advance one frame for lanes [firstLane, lastLane)
+// Each step runs as its own loop across lanes so that it can be vectorised
+void FlangerBatchEngine::processFrame(int firstLane, int lastLane)
+{
+    readLanes(delayLines.data(), writeHeads.data(), lfoCos.data(), delayMinimums.data(), depthSamples.data(),
+              laneDelayed.data(), firstLane, lastLane);
+    mixLanes(laneSamples.data(), laneDelayed.data(), laneRegen.data(), dryGains.data(), wetGains.data(),
+             regenDryGains.data(), regenWetGains.data(), firstLane, lastLane);
+    writeLanes(delayLines.data(), writeHeads.data(), laneRegen.data(), firstLane, lastLane);
+    rotateLanes(lfoCos.data(), lfoSin.data(), lfoStepCos.data(), lfoStepSin.data(), firstLane, lastLane);
+}
+
+// Read the delay line of every lane at its modulated delay
+void FlangerBatchEngine::readLanes(const float* __restrict lines, const int* __restrict heads, const float* __restrict cosValues,
+                                   const float* __restrict minimums, const float* __restrict depths, float* __restrict delayed,
+                                   int firstLane, int lastLane)
+{
+    for (int lane = firstLane; lane < lastLane; lane++)
+    {
+        float delay = minimums[lane] + (depths[lane] / 2.0f) * (1.0f + cosValues[lane]);
+        int intDelay = (int)delay;
+        float fracDelay = delay - (float)intDelay;
+
+        int lineStart = lane * lineLength;
+        float newer = lines[lineStart + ((heads[lane] - intDelay) & lineMask)];
+        float older = lines[lineStart + ((heads[lane] - intDelay - 1) & lineMask)];
+        delayed[lane] = newer * (1.0f - fracDelay) + older * fracDelay;
+    }
+}
+
+// Calculate output values and regeneration values
+void FlangerBatchEngine::mixLanes(float* __restrict samples, const float* __restrict delayed, float* __restrict regen,
+                                  const float* __restrict dry, const float* __restrict wet,
+                                  const float* __restrict regenDry, const float* __restrict regenWet,
+                                  int firstLane, int lastLane)
+{
+    for (int lane = firstLane; lane < lastLane; lane++)
+    {
+        float bufferSample = samples[lane];
+        samples[lane] = dry[lane] * bufferSample + wet[lane] * delayed[lane];
+        regen[lane] = regenDry[lane] * bufferSample + regenWet[lane] * delayed[lane];
+    }
+}
+
+// Write the regeneration values and move the write heads on
+// The writes are a scatter, so only the head update vectorises without scatter instructions
+void FlangerBatchEngine::writeLanes(float* __restrict lines, int* __restrict heads, const float* __restrict regen, int firstLane, int lastLane)
+{
+    for (int lane = firstLane; lane < lastLane; lane++)
+        lines[lane * lineLength + heads[lane]] = regen[lane];
+
+    for (int lane = firstLane; lane < lastLane; lane++)
+        heads[lane] = (heads[lane] + 1) & lineMask;
+}
+
+// Advance the LFOs by rotating their phasors
+void FlangerBatchEngine::rotateLanes(float* __restrict c, float* __restrict s, const float* __restrict stepCos, const float* __restrict stepSin,
+                                     int firstLane, int lastLane)
+{
+    for (int lane = firstLane; lane < lastLane; lane++)
+    {
+        float oldCos = c[lane];
+        c[lane] = oldCos * stepCos[lane] - s[lane] * stepSin[lane];
+        s[lane] = oldCos * stepSin[lane] + s[lane] * stepCos[lane];
+    }
+}
+
+void FlangerBatchEngine::normaliseLFOs()
+{
+    for (int lane = 0; lane < numLanes; lane++)
+    {
+        float scale = 1.0f / sqrtf(lfoCos[(size_t)lane] * lfoCos[(size_t)lane] + lfoSin[(size_t)lane] * lfoSin[(size_t)lane]);
+        lfoCos[(size_t)lane] *= scale;
+        lfoSin[(size_t)lane] *= scale;
+    }
+
+    framesSinceNormalise = 0;
+}
+
+//==============================================================================
+double FlangerBatchEngine::getFramesPerSecondPerCore()
+{
+    if (processingSeconds <= 0.0)
+        return 0.0;
+
+    return processedLaneFrames / processingSeconds;
+}
+
+double FlangerBatchEngine::getRealtimeStreamsPerCore()
+{
+    if (channelsPerStream <= 0)
+        return 0.0;
+
+    return getFramesPerSecondPerCore() / (currentSampleRate * (double)channelsPerStream);
+}
+
+void FlangerBatchEngine::resetStatistics()
+{
+    processedLaneFrames = 0.0;
+    processingSeconds = 0.0;
+}
@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+    Purpose: Batch Flanger Engine Header File
+
+    Runs the flanger for many independent streams in one call.
+    All per-stream state is kept in structure-of-arrays form so each frame is
+    advanced for every stream by loops that run across streams (SIMD lanes).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#define _USE_MATH_DEFINES
+
+#include <JuceHeader.h>
+#include <math.h>
+#include <vector>
+
+
+//==============================================================================
+/*
+    Settings of one stream, with the same meaning as the processor's parameters
+*/
+struct FlangerSettings
+{
+    float f_ratio = 1.059f;
+    float lfoFrequency = 1.0f;
+    // Phase offset in radians of every channel after the first
+    float phaseOffset = 0.0f;
+    int delayMinimum = 9;
+    float delayGain = 0.8f;
+    float regenGain = 0.0f;
+};
+
+/*
+    Audio of one stream for a processBatch call, processed in place
+    channels holds one pointer per channel of the stream
+*/
+struct FlangerStream
+{
+    float* const* channels = nullptr;
+    int numFrames = 0;
+};
+
+/*
+Class: FlangerBatchEngine
+       Flanger state for many streams of the same channel count
+       Each channel of each stream is one lane: lane = stream * channelsPerStream + channel
+       Delay lines of all lanes share one contiguous allocation
+       The LFO of each lane is a rotating phasor, so advancing it needs no trigonometry
+       The LFO is not bit-compatible with the processor's LFO class: the phasor runs at the
+       exact frequency and accumulates float rounding between renormalisations, while the
+       processor's period is rounded down to a whole number of samples
+       Output therefore drifts away from the processor's over time, by up to about 1e-3
+       after 3 s at 1 Hz and 2e-2 at 0.7 Hz
+*/
+class FlangerBatchEngine
+{
+public:
+    // Constructor
+    FlangerBatchEngine() {};
+
+    // Delay line length per lane, a power of two so wrapping is a mask
+    // Longer than the largest delayMinimum plus depth the editor can produce
+    static constexpr int lineLength = 8192;
+
+    // Allocate and clear the state for numStreams streams
+    // Must not be called while processBatch is running
+    void prepare(int newNumStreams, int numChannelsPerStream, double sampleRate);
+
+    // Update the settings of one stream
+    void setStreamSettings(int streamIndex, const FlangerSettings& settings);
+
+    // Process streams[0..numBatchStreams) in place, streams[i] belonging to prepared stream i
+    // Frames common to all streams are processed in lockstep across lanes,
+    // any extra frames of longer streams are processed afterwards for their lanes only
+    void processBatch(FlangerStream* streams, int numBatchStreams);
+
+    // Lane-frames processed per second of processing time on the calling thread
+    double getFramesPerSecondPerCore();
+    // Number of streams one core could process in real time at the measured rate
+    double getRealtimeStreamsPerCore();
+    // Clear the throughput statistics
+    void resetStatistics();
+
+    int getNumStreams()
+    {
+        return numStreams;
+    };
+
+private:
+    // Advance one frame for lanes [firstLane, lastLane), reading and replacing laneSamples
+    void processFrame(int firstLane, int lastLane);
+
+    // The steps of processFrame, one loop across lanes each
+    // Arrays passed to one call never overlap, which __restrict tells the compiler so it can vectorise them
+    static void readLanes(const float* __restrict lines, const int* __restrict heads, const float* __restrict cosValues,
+                          const float* __restrict minimums, const float* __restrict depths, float* __restrict delayed,
+                          int firstLane, int lastLane);
+    static void mixLanes(float* __restrict samples, const float* __restrict delayed, float* __restrict regen,
+                         const float* __restrict dry, const float* __restrict wet,
+                         const float* __restrict regenDry, const float* __restrict regenWet,
+                         int firstLane, int lastLane);
+    static void writeLanes(float* __restrict lines, int* __restrict heads, const float* __restrict regen, int firstLane, int lastLane);
+    static void rotateLanes(float* __restrict c, float* __restrict s, const float* __restrict stepCos, const float* __restrict stepSin,
+                            int firstLane, int lastLane);
+    // Pull out rounding drift of the LFO phasors
+    void normaliseLFOs();
+
+    int numStreams = 0;
+    int channelsPerStream = 0;
+    int numLanes = 0;
+    double currentSampleRate = 48000.0;
+    static constexpr int lineMask = lineLength - 1;
+    // Frames between phasor renormalisations
+    static constexpr int normaliseInterval = 64;
+    int framesSinceNormalise = 0;
+
+    // Per-stream settings, kept to apply phase offset changes relative to the old offset
+    std::vector<FlangerSettings> streamSettings;
+
+    // Per-lane state
+    std::vector<int> writeHeads;
+    std::vector<float> lfoCos;
+    std::vector<float> lfoSin;
+    std::vector<float> lfoStepCos;
+    std::vector<float> lfoStepSin;
+    std::vector<float> delayMinimums;
+    std::vector<float> depthSamples;
+    std::vector<float> dryGains;
+    std::vector<float> wetGains;
+    std::vector<float> regenDryGains;
+    std::vector<float> regenWetGains;
+
+    // Per-lane scratch for the current frame
+    std::vector<float> laneSamples;
+    std::vector<float> laneDelayed;
+    std::vector<float> laneRegen;
+
+    // Delay lines of all lanes, lane n starting at n * lineLength
+    std::vector<float> delayLines;
+
+    // Throughput statistics
+    double processedLaneFrames = 0.0;
+    double processingSeconds = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FlangerBatchEngine)
+};
@@ -0,0 +1,270 @@
+/*
+  ==============================================================================
+    Purpose: Flanger Cascade Header File
+
+    Extra flanger stages that the processor runs in series after its own stage,
+    for through-zero-style and "jet" sounds without chaining plugin instances.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <vector>
+#include "PluginProcessor.h"
+
+
+//==============================================================================
+/*
+Class: FlangerCascade
+       Up to three extra flanger stages run in series after the processor's own stage
+       Every stage processes the same sub-block in place straight after the previous one,
+       so the signal between stages stays in the L1-resident sub-block
+       The delay lines of all stages come from one contiguous allocation
+       A stage whose LFO is in sync with an earlier stage's (same rate, phase and offset)
+       reuses that stage's LFO values instead of evaluating its own
+*/
+class FlangerCascade
+{
+public:
+    static constexpr int maxExtraStages = 3;
+    // Largest number of frames processed per call
+    static constexpr int maxFrames = 32;
+
+    // Constructor
+    FlangerCascade()
+    {
+        // One line per stage and channel, stage-major
+        lines = std::vector<float>((size_t)(maxExtraStages * 2 * lineLength), 0.0f);
+        stageLFOs = std::vector<LFO>((size_t)(maxExtraStages * 2), LFO(1.0f));
+    };
+
+    // Return the number of extra stages in use
+    int getNumExtraStages()
+    {
+        return numExtraStages;
+    };
+
+    // Change the number of extra stages in use
+    // Newly enabled stages start from silent delay lines with their LFOs aligned to the
+    // processor's LFOs, so stages at the same rate share LFO values straight away
+    void setNumExtraStages(int newNumExtraStages, const LFO& mainLeftLFO, const LFO& mainRightLFO)
+    {
+        newNumExtraStages = juce::jlimit(0, maxExtraStages, newNumExtraStages);
+
+        for (int stage = numExtraStages; stage < newNumExtraStages; stage++)
+        {
+            for (int channel = 0; channel < 2; channel++)
+            {
+                std::fill(getLine(stage, channel), getLine(stage, channel) + lineLength, 0.0f);
+                heads[stage][channel] = 0;
+
+                LFO& lfo = getLFO(stage, channel);
+                float phaseOffset = lfo.getPhaseOffset();
+                lfo = (channel == 0) ? mainLeftLFO : mainRightLFO;
+                lfo.resetFrequency(stageFrequencies[stage]);
+                lfo.setPhaseOffset(phaseOffset);
+            }
+        }
+
+        numExtraStages = newNumExtraStages;
+    };
+
+    // Set the modulation of every extra stage from the processor's settings
+    // Stage s (counting the processor's stage as 0) runs its LFO at rate * rateSpread^s,
+    // depth, delay and phase offset are shared with the processor's stage
+    // The stages' lines are shorter than the processor's, so longer delays are limited to fit
+    void setStageModulation(float f_ratio, float rate, float rateSpread, int delayMinimum, float phaseOffset)
+    {
+        int stageDelay = juce::jlimit(1, lineLength - 2, delayMinimum);
+
+        float stageRate = rate;
+        for (int stage = 0; stage < maxExtraStages; stage++)
+        {
+            stageRate *= rateSpread;
+            // Convert the frequency ratio into a number of samples as the processor does,
+            // limited so that the longest delay still fits into the stage's line
+            stageDepths[stage] = 48000.0f * ((f_ratio - 1.0f) / (float)(2.0f * M_PI * stageRate));
+            stageDepths[stage] = juce::jmin(stageDepths[stage], (float)(lineLength - 2 - stageDelay));
+
+            // Only touch the LFOs when their settings change, so they keep their phase
+            // (and stay in sync with the LFOs they share values with) under other parameter changes
+            if (stageRate != stageFrequencies[stage])
+            {
+                stageFrequencies[stage] = stageRate;
+                getLFO(stage, 0).resetFrequency(stageRate);
+                getLFO(stage, 1).resetFrequency(stageRate);
+            }
+
+            if (phaseOffset != getLFO(stage, 1).getPhaseOffset())
+                getLFO(stage, 1).setPhaseOffset(phaseOffset);
+        }
+
+        stageDelayMinimum = (float)stageDelay;
+    };
+
+    // Set the mixing gains of every extra stage, shared with the processor's stage
+    void setStageGains(float delayGain, float regenGain)
+    {
+        dryGain = 1.0f - delayGain;
+        wetGain = delayGain;
+        regenDryGain = 1.0f - regenGain;
+        regenWetGain = regenGain;
+    };
+
+    // Return the LFO of an extra stage, e.g. to check that it is in sync with another LFO
+    LFO& getStageLFO(int stage, int channel)
+    {
+        return getLFO(stage, channel);
+    };
+
+    // Decide, once per sub-block and before any stage advances, where each stage's LFO values come from
+    // The processor's LFOs must be passed in their state at the start of the sub-block
+    void prepareSubBlock(LFO& mainLeftLFO, LFO& mainRightLFO)
+    {
+        for (int channel = 0; channel < 2; channel++)
+        {
+            LFO& mainLFO = (channel == 0) ? mainLeftLFO : mainRightLFO;
+
+            for (int stage = 0; stage < numExtraStages; stage++)
+            {
+                LFO& lfo = getLFO(stage, channel);
+                int source = noSource;
+
+                if (lfo.isInSyncWith(mainLFO))
+                    source = mainSource;
+                else
+                {
+                    for (int earlier = 0; earlier < stage && source == noSource; earlier++)
+                    {
+                        if (lfo.isInSyncWith(getLFO(earlier, channel)))
+                            source = earlier;
+                    }
+                }
+
+                lfoSources[stage][channel] = source;
+            }
+        }
+    };
+
+    // Run every extra stage over numFrames (at most maxFrames) samples of one channel in place
+    // mainLFOValues holds the processor's LFO value for each frame of the sub-block
+    void processChannelSubBlock(float* channelData, int channel, int numFrames, const float* mainLFOValues, int controlInterval)
+    {
+        for (int stage = 0; stage < numExtraStages; stage++)
+        {
+            LFO& lfo = getLFO(stage, channel);
+            int source = lfoSources[stage][channel];
+
+            // Evaluate this stage's LFO only if no earlier stage has the same values
+            if (source == noSource)
+            {
+                for (int index = 0; index < numFrames; index++)
+                {
+                    lfoScratch[stage][index] = lfo.getControlRateValue(controlInterval);
+                    lfo.incrementLFO();
+                }
+                lfoValues[stage] = lfoScratch[stage];
+            }
+            else
+            {
+                lfoValues[stage] = (source == mainSource) ? mainLFOValues : lfoValues[source];
+                lfo.incrementLFO(numFrames);
+            }
+
+            // Delays in samples (positive), tracking the shortest one
+            // Written as the negated getDelayChange so the rounding matches the processor's stage
+            const float* values = lfoValues[stage];
+            float halfDepth = stageDepths[stage] / 2.0f;
+            float shortestDelay = (float)lineLength;
+            for (int index = 0; index < numFrames; index++)
+            {
+                delayScratch[index] = -(-stageDelayMinimum - halfDepth * (1.0f + values[index]));
+                shortestDelay = std::min(shortestDelay, delayScratch[index]);
+            }
+
+            float* line = getLine(stage, channel);
+            int& head = heads[stage][channel];
+
+            // As in the processor's stage, reads only depend on writes from this sub-block
+            // when the shortest delay is shorter than the sub-block
+            if ((int)shortestDelay >= numFrames)
+            {
+                for (int index = 0; index < numFrames; index++)
+                    delayedScratch[index] = readLine(line, head + index, delayScratch[index]);
+
+                for (int index = 0; index < numFrames; index++)
+                {
+                    float bufferSample = channelData[index];
+                    channelData[index] = dryGain * bufferSample + wetGain * delayedScratch[index];
+                    line[(head + index) & lineMask] = regenDryGain * bufferSample + regenWetGain * delayedScratch[index];
+                }
+
+                head = (head + numFrames) & lineMask;
+            }
+            else
+            {
+                for (int index = 0; index < numFrames; index++)
+                {
+                    float delaySample = readLine(line, head, delayScratch[index]);
+                    float bufferSample = channelData[index];
+                    channelData[index] = dryGain * bufferSample + wetGain * delaySample;
+                    line[head] = regenDryGain * bufferSample + regenWetGain * delaySample;
+                    head = (head + 1) & lineMask;
+                }
+            }
+        }
+    };
+
+private:
+    // Power of two, long enough for the longest delay the editor allows
+    static constexpr int lineLength = 8192;
+    static constexpr int lineMask = lineLength - 1;
+    // LFO sources for prepareSubBlock, otherwise the index of an earlier extra stage
+    static constexpr int noSource = -1;
+    static constexpr int mainSource = -2;
+
+    float* getLine(int stage, int channel)
+    {
+        return lines.data() + (size_t)((stage * 2 + channel) * lineLength);
+    };
+
+    LFO& getLFO(int stage, int channel)
+    {
+        return stageLFOs[(size_t)(stage * 2 + channel)];
+    };
+
+    // Linear interpolation delay samples before position, matching MyDelayLine::getLinearSample
+    float readLine(const float* line, int position, float delay)
+    {
+        int intDelay = (int)delay;
+        float fracDelay = delay - (float)intDelay;
+        int newer = (position - intDelay) & lineMask;
+        int older = (newer - 1) & lineMask;
+
+        return line[newer] * (1.0f - fracDelay) + line[older] * fracDelay;
+    };
+
+    int numExtraStages = 0;
+    std::vector<float> lines;
+    std::vector<LFO> stageLFOs;
+    int heads[maxExtraStages][2] = {};
+    int lfoSources[maxExtraStages][2] = {};
+
+    // Settings
+    float stageFrequencies[maxExtraStages] = { 1.0f, 1.0f, 1.0f };
+    float stageDepths[maxExtraStages] = {};
+    float stageDelayMinimum = 9.0f;
+    float dryGain = 0.2f;
+    float wetGain = 0.8f;
+    float regenDryGain = 1.0f;
+    float regenWetGain = 0.0f;
+
+    // Per sub-block scratch
+    const float* lfoValues[maxExtraStages] = {};
+    float lfoScratch[maxExtraStages][maxFrames];
+    float delayScratch[maxFrames];
+    float delayedScratch[maxFrames];
+};
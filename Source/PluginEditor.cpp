@@ -108,27 +108,115 @@ MyPlugInAudioProcessorEditor::MyPlugInAudioProcessorEditor (MyPlugInAudioProcess
     regenGain.setValue(0.0);
     addAndMakeVisible(&regenGain);
     regenGain.addListener(this);
+
+    // cascadeStages parameters
+    cascadeStages.setSliderStyle(juce::Slider::Rotary);
+    cascadeStages.setRotaryParameters(-2.34, 2.34, true);
+    cascadeStages.setRange(1, 4, 1);
+    cascadeStages.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 25);
+    cascadeStages.setPopupDisplayEnabled(true, false, this);
+    cascadeStages.setTextValueSuffix("");
+    cascadeStages.setValue(1);
+    addAndMakeVisible(&cascadeStages);
+    cascadeStages.addListener(this);
+
+    // stageRateSpread parameters
+    stageRateSpread.setSliderStyle(juce::Slider::Rotary);
+    stageRateSpread.setRotaryParameters(-2.34, 2.34, true);
+    stageRateSpread.setRange(1, 2, 0.01);
+    stageRateSpread.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 25);
+    stageRateSpread.setPopupDisplayEnabled(true, false, this);
+    stageRateSpread.setTextValueSuffix("");
+    stageRateSpread.setValue(1.0);
+    addAndMakeVisible(&stageRateSpread);
+    stageRateSpread.addListener(this);
+
+    // Show the processor's current settings, so opening the editor doesn't change the sound
+    showProcessorValues();
 }
 
-// Pull new values when a slider value changes
-void MyPlugInAudioProcessorEditor::sliderValueChanged(juce::Slider* slider)
+// Set every slider from the processor's current parameter values without notifying the listener
+void MyPlugInAudioProcessorEditor::showProcessorValues()
 {
-    audioProcessor.f_ratio = (float)freqDepth.getValue();
-
-    audioProcessor.left_LFO1.resetFrequency( (float)rateCoarse.getValue() + (float)rateFine.getValue() );
-    audioProcessor.right_LFO1.resetFrequency( (float)rateCoarse.getValue() + (float)rateFine.getValue() );
+    freqDepth.setValue(audioProcessor.getParameterValue(ParameterId::Depth), juce::dontSendNotification);
 
-    audioProcessor.delayMinimum = 48 * (int)delayCoarse.getValue() + (int)delayFine.getValue();
+    // Rate is coarse + fine, with fine in 0.1 to 1 Hz
+    float rate = audioProcessor.getParameterValue(ParameterId::Rate);
+    int rateWholeHz = juce::jlimit(0, 8, (int)std::ceil(rate - 1.0f));
+    rateCoarse.setValue(rateWholeHz, juce::dontSendNotification);
+    rateFine.setValue(rate - (float)rateWholeHz, juce::dontSendNotification);
 
-    audioProcessor.right_LFO1.setPhaseOffset(phaseBalance.getValue() * (float) M_PI / 180.0f);
+    // Delay is 48 * coarse + fine, with fine in 1 to 48 samples
+    int delay = (int)audioProcessor.getParameterValue(ParameterId::Delay);
+    int delayMilliseconds = juce::jlimit(0, 30, (delay - 1) / 48);
+    delayCoarse.setValue(delayMilliseconds, juce::dontSendNotification);
+    delayFine.setValue(delay - 48 * delayMilliseconds, juce::dontSendNotification);
 
-    audioProcessor.delayGain = delayGain.getValue();
+    phaseBalance.setValue(audioProcessor.getParameterValue(ParameterId::PhaseOffset), juce::dontSendNotification);
+    delayGain.setValue(audioProcessor.getParameterValue(ParameterId::DelayGain), juce::dontSendNotification);
+    regenGain.setValue(audioProcessor.getParameterValue(ParameterId::RegenGain), juce::dontSendNotification);
+    cascadeStages.setValue(audioProcessor.getParameterValue(ParameterId::CascadeStages), juce::dontSendNotification);
+    stageRateSpread.setValue(audioProcessor.getParameterValue(ParameterId::CascadeRateSpread), juce::dontSendNotification);
+}
 
-    audioProcessor.regenGain = regenGain.getValue();
+// Pull the new value of the slider that changed
+// Values go through the processor's host parameters, so the host can record them,
+// and on to the audio thread through the processor's lock-free parameter channel
+// Only the changed parameter is sent, so values set by MIDI controllers are kept
+void MyPlugInAudioProcessorEditor::sliderValueChanged(juce::Slider* slider)
+{
+    if (slider == &freqDepth)
+        audioProcessor.setParameterFromEditor(ParameterId::Depth, (float)freqDepth.getValue());
+    else if (slider == &rateCoarse || slider == &rateFine)
+        audioProcessor.setParameterFromEditor(ParameterId::Rate, (float)rateCoarse.getValue() + (float)rateFine.getValue());
+    else if (slider == &delayCoarse || slider == &delayFine)
+        audioProcessor.setParameterFromEditor(ParameterId::Delay, (float)(48 * (int)delayCoarse.getValue() + (int)delayFine.getValue()));
+    else if (slider == &phaseBalance)
+        audioProcessor.setParameterFromEditor(ParameterId::PhaseOffset, (float)phaseBalance.getValue());
+    else if (slider == &delayGain)
+        audioProcessor.setParameterFromEditor(ParameterId::DelayGain, (float)delayGain.getValue());
+    else if (slider == &regenGain)
+        audioProcessor.setParameterFromEditor(ParameterId::RegenGain, (float)regenGain.getValue());
+    else if (slider == &cascadeStages)
+        audioProcessor.setParameterFromEditor(ParameterId::CascadeStages, (float)cascadeStages.getValue());
+    else if (slider == &stageRateSpread)
+        audioProcessor.setParameterFromEditor(ParameterId::CascadeRateSpread, (float)stageRateSpread.getValue());
 
 
 };
 
+// Tell the host when a slider drag starts and ends, for touch automation
+void MyPlugInAudioProcessorEditor::sliderDragStarted(juce::Slider* slider)
+{
+    audioProcessor.beginParameterGesture(getSliderParameter(slider));
+}
+
+void MyPlugInAudioProcessorEditor::sliderDragEnded(juce::Slider* slider)
+{
+    audioProcessor.endParameterGesture(getSliderParameter(slider));
+}
+
+// Return the parameter a slider controls
+ParameterId MyPlugInAudioProcessorEditor::getSliderParameter(juce::Slider* slider)
+{
+    if (slider == &rateCoarse || slider == &rateFine)
+        return ParameterId::Rate;
+    if (slider == &delayCoarse || slider == &delayFine)
+        return ParameterId::Delay;
+    if (slider == &phaseBalance)
+        return ParameterId::PhaseOffset;
+    if (slider == &delayGain)
+        return ParameterId::DelayGain;
+    if (slider == &regenGain)
+        return ParameterId::RegenGain;
+    if (slider == &cascadeStages)
+        return ParameterId::CascadeStages;
+    if (slider == &stageRateSpread)
+        return ParameterId::CascadeRateSpread;
+
+    return ParameterId::Depth;
+}
+
 MyPlugInAudioProcessorEditor::~MyPlugInAudioProcessorEditor()
 {
 }
@@ -151,6 +239,8 @@ void MyPlugInAudioProcessorEditor::paint (juce::Graphics& g)
     g.drawFittedText("Delay (Fine)", 395, 130, 60, 30, juce::Justification::centred, 2, 1.0f);
     g.drawFittedText("Phase Offset", 485, 130, 60, 30, juce::Justification::centred, 2, 1.0f);
     g.drawFittedText("Delay Gain", 215, 270, 60, 30, juce::Justification::centred, 2, 1.0f);
+    g.drawFittedText("Stages", 395, 270, 60, 30, juce::Justification::centred, 2, 1.0f);
+    g.drawFittedText("Rate Spread", 485, 270, 60, 30, juce::Justification::centred, 2, 1.0f);
     g.setFont(15.0f);
     g.drawFittedText("Regeneration", 270, 270, 120, 30, juce::Justification::centred, 2, 1.0f);
 }
@@ -166,4 +256,6 @@ void MyPlugInAudioProcessorEditor::resized()
     phaseBalance.setBounds(450, 160, getWidth() * .22, getHeight() * .22);
     delayGain.setBounds(180, 300, getWidth() * .22, getHeight() * .22);
     regenGain.setBounds(270, 300, getWidth() * .22, getHeight() * .22);
+    cascadeStages.setBounds(360, 300, getWidth() * .22, getHeight() * .22);
+    stageRateSpread.setBounds(450, 300, getWidth() * .22, getHeight() * .22);
 }
@@ -31,6 +31,10 @@ public:
 
 private:
     void sliderValueChanged(juce::Slider* slider) override;
+    void sliderDragStarted(juce::Slider* slider) override;
+    void sliderDragEnded(juce::Slider* slider) override;
+    ParameterId getSliderParameter(juce::Slider* slider);
+    void showProcessorValues();
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     MyPlugInAudioProcessor& audioProcessor;
@@ -43,6 +47,8 @@ private:
     juce::Slider phaseBalance;
     juce::Slider delayGain;
     juce::Slider regenGain;
+    juce::Slider cascadeStages;
+    juce::Slider stageRateSpread;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MyPlugInAudioProcessorEditor)
 };
@@ -12,6 +12,8 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "FlangerCascade.h"
+#include "RealtimeSanitizer.h"
 
 //==============================================================================
 MyPlugInAudioProcessor::MyPlugInAudioProcessor()
@@ -26,6 +28,37 @@ MyPlugInAudioProcessor::MyPlugInAudioProcessor()
                        )
 #endif
 {
+    static_assert(subBlockSize <= FlangerCascade::maxFrames, "Cascade scratch must hold a whole sub-block");
+    cascade = std::make_unique<FlangerCascade>();
+
+    // Default MIDI controller mapping, ranges as in the editor
+    setMidiControllerMapping(1, ParameterId::Depth, 1.0f, 1.059f);
+    setMidiControllerMapping(20, ParameterId::Rate, 0.1f, 9.0f);
+    setMidiControllerMapping(21, ParameterId::Delay, 1.0f, 1488.0f);
+    setMidiControllerMapping(22, ParameterId::DelayGain, 0.0f, 1.0f);
+    setMidiControllerMapping(23, ParameterId::RegenGain, 0.0f, 0.95f);
+
+    // Starting values reported by getParameterValue
+    currentParameterValues[(int)ParameterId::Depth].store(f_ratio);
+    currentParameterValues[(int)ParameterId::Rate].store(left_LFO1.getFrequency());
+    currentParameterValues[(int)ParameterId::Delay].store((float)delayMinimum);
+    currentParameterValues[(int)ParameterId::PhaseOffset].store(right_LFO1.getPhaseOffset() * 180.0f / (float)M_PI);
+    currentParameterValues[(int)ParameterId::DelayGain].store(delayGain);
+    currentParameterValues[(int)ParameterId::RegenGain].store(regenGain);
+    currentParameterValues[(int)ParameterId::CascadeStages].store((float)(cascade->getNumExtraStages() + 1));
+    currentParameterValues[(int)ParameterId::CascadeRateSpread].store(cascadeRateSpread);
+
+    // Parameters the host can automate, starting from the values above
+    addHostParameter(ParameterId::Depth, "depth", "Depth", 0.0f);
+    addHostParameter(ParameterId::Rate, "rate", "Rate", 0.0f);
+    addHostParameter(ParameterId::Delay, "delay", "Delay", 1.0f);
+    addHostParameter(ParameterId::PhaseOffset, "phase", "Phase Offset", 0.0f);
+    addHostParameter(ParameterId::DelayGain, "delayGain", "Delay Gain", 0.0f);
+    addHostParameter(ParameterId::RegenGain, "regenGain", "Regeneration", 0.0f);
+    addHostParameter(ParameterId::CascadeStages, "stages", "Stages", 1.0f);
+    addHostParameter(ParameterId::CascadeRateSpread, "rateSpread", "Rate Spread", 0.0f);
+
+    updateCascadeStages();
 }
 
 MyPlugInAudioProcessor::~MyPlugInAudioProcessor()
@@ -38,6 +71,9 @@ const juce::String MyPlugInAudioProcessor::getName() const
     return JucePlugin_Name;
 }
 
+// MIDI controller mapping (setMidiControllerMapping) needs MIDI input, which the plugin
+// formats only receive once "Plugin MIDI Input" is enabled in the project settings
+// (JucePlugin_WantsMidiInput). Host automation works without it through the host parameters
 bool MyPlugInAudioProcessor::acceptsMidi() const
 {
    #if JucePlugin_WantsMidiInput
@@ -99,6 +135,9 @@ void MyPlugInAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlo
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
+
+    // Block deadlines for the quality governor come from the real sample rate
+    qualityGovernor.setSampleRate(sampleRate);
 }
 
 void MyPlugInAudioProcessor::releaseResources()
@@ -134,72 +173,503 @@ bool MyPlugInAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 // All code written for ECE 484 in this file appears in this method
 void MyPlugInAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    // Debug/test builds with MYPLUGIN_RT_SANITIZER check that nothing in here can block
+    MYPLUGIN_REALTIME_SCOPE
     juce::ScopedNoDenormals noDenormals;
+    auto startTicks = juce::Time::getHighResolutionTicks();
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
     auto numSamples = buffer.getNumSamples();
-    auto numChannels = buffer.getNumChannels();
-
-    // Set up values to store data in various stages
-    float delaySample = 0.0f;
-    float bufferSample = 0.0f;
-    float newValue = 0.0f;
-    float regenValue = 0.0f;
-    float depthLeftSamples;
-    float depthRightSamples;
-    float delayChange = 0.0f;
 
-    // Convert the vibrato's frequency ratio into a number of samples
-    depthLeftSamples = 48000.0f * (((float)f_ratio - 1.0f) / (float)(2.0f * M_PI * (float)left_LFO1.getFrequency()));
-    depthRightSamples = 48000.0f * (((float)f_ratio - 1.0f) / (float)(2.0f * M_PI * (float)right_LFO1.getFrequency()));
+    // Changes from other threads apply at the start of the block,
+    // timestamped events from MIDI controllers and queueParameterEvent at their sample position
+    applyPendingParameters();
+    updateDerivedParameters();
+    collectMidiEvents(midiMessages);
 
-
-    // Pull a frame of audio samples into a buffer
-    juce::AudioBuffer<float> processBuffer = juce::AudioBuffer<float>(totalNumOutputChannels, numSamples);
+    // Pick the quality tier for this block and start a crossfade if it changed
+    // A change waits until the previous crossfade has finished, so a fade always starts from a single tier
+    QualityTier targetTier = qualityGovernor.chooseTier(isNonRealtime());
+    if (targetTier != currentTier && tierFadeRemaining == 0)
+    {
+        previousTier = currentTier;
+        currentTier = targetTier;
+        tierFadeRemaining = tierFadeLength;
+    }
 
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    // Loop over stereo channels
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+    // Split the block at each event position
+    // Derived values are only recomputed at the splits, not per sample
+    int startSample = 0;
+    int eventIndex = 0;
+    while (eventIndex < numBlockEvents)
     {
-        // Get a pointer to the beginning of the channel buffer
-        auto* channelData = buffer.getWritePointer (channel);
+        int eventSample = juce::jlimit(0, numSamples, blockEvents[eventIndex].sampleOffset);
+        processRange(buffer, totalNumInputChannels, startSample, eventSample);
+        startSample = eventSample;
 
-        // Loop over indices in the channel
-        for (int index = 0; index < numSamples; index++)
+        // Apply every event at this position before recomputing
+        while (eventIndex < numBlockEvents && juce::jlimit(0, numSamples, blockEvents[eventIndex].sampleOffset) == eventSample)
         {
-            // Calculate the number of samples of delay needed for the vibrato portion and increment the LFO
-            if (channel == 0) 
-            {
-                delayChange = -1.0f * delayMinimum - ( (float)depthLeftSamples / 2.0f ) * (1.0f + (float)left_LFO1.getCurrentValue());
-                left_LFO1.incrementLFO();
-            }
-            else if (channel == 1) 
+            applyParameter(blockEvents[eventIndex].id, blockEvents[eventIndex].value);
+            eventIndex++;
+        }
+
+        // Only passes on settings that the events changed
+        updateDerivedParameters();
+        if (cascade->getNumExtraStages() > 0)
+            updateCascadeStages();
+    }
+
+    numBlockEvents = 0;
+    processRange(buffer, totalNumInputChannels, startSample, numSamples);
+
+    // Feed the measured processing time back to the governor
+    qualityGovernor.reportBlockTime(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks), numSamples);
+}
+
+// Process whole sub-blocks with a constant frame count, then the remainder
+void MyPlugInAudioProcessor::processRange(juce::AudioBuffer<float>& buffer, int numInputChannels, int startSample, int endSample)
+{
+    for (; startSample + subBlockSize <= endSample; startSample += subBlockSize)
+        processSubBlock<subBlockSize>(buffer, numInputChannels, startSample, subBlockSize);
+
+    if (startSample < endSample)
+        processSubBlock<variableNumFrames>(buffer, numInputChannels, startSample, endSample - startSample);
+}
+
+// Process every input channel of one sub-block, then advance the tier crossfade
+template <int fixedNumFrames>
+void MyPlugInAudioProcessor::processSubBlock(juce::AudioBuffer<float>& buffer, int numInputChannels, int startSample, int numFrames)
+{
+    if (fixedNumFrames != variableNumFrames)
+        numFrames = fixedNumFrames;
+
+    // Identical input and channel settings on both sides (e.g. a mono source on a stereo bus)
+    bool channelsMatch = numInputChannels == 2
+        && std::memcmp(buffer.getReadPointer(0, startSample), buffer.getReadPointer(1, startSample), sizeof(float) * (size_t)numFrames) == 0
+        && depthSamples[0] == depthSamples[1]
+        && left_LFO1.isInSyncWith(right_LFO1)
+        && simpleDelay.getHead(0) == simpleDelay.getHead(1)
+        && cascade->getNumExtraStages() == 0;
+
+    lastSubBlockDualMono = channelsMatch && matchingFramesRun >= simpleDelay.getLength();
+
+    if (lastSubBlockDualMono)
+    {
+        // Both delay lines are identical, so process the left channel once,
+        // mirror its state changes to the right channel and copy the output
+        float* leftData = buffer.getWritePointer(0, startSample);
+        processChannelSubBlock<fixedNumFrames>(leftData, 0, numFrames, true);
+        juce::FloatVectorOperations::copy(buffer.getWritePointer(1, startSample), leftData, numFrames);
+    }
+    else
+    {
+        bool cascading = cascade->getNumExtraStages() > 0;
+        if (cascading)
+            cascade->prepareSubBlock(left_LFO1, right_LFO1);
+
+        // Loop over stereo channels
+        // Extra cascade stages run straight after this stage on the same sub-block
+        for (int channel = 0; channel < numInputChannels; ++channel)
+        {
+            float* channelData = buffer.getWritePointer(channel, startSample);
+            processChannelSubBlock<fixedNumFrames>(channelData, channel, numFrames, false);
+            if (cascading)
+                cascade->processChannelSubBlock(channelData, channel, numFrames, lfoScratch, getControlInterval(currentTier));
+        }
+
+        // Count frames in which both delay lines received the same writes
+        if (channelsMatch && std::memcmp(regenScratch[0], regenScratch[1], sizeof(float) * (size_t)numFrames) == 0)
+            matchingFramesRun += numFrames;
+        else
+            matchingFramesRun = 0;
+    }
+
+    tierFadeRemaining = juce::jmax(0, tierFadeRemaining - numFrames);
+}
+
+template <int fixedNumFrames>
+void MyPlugInAudioProcessor::processChannelSubBlock(float* channelData, int channel, int numFrames, bool mirrorToRight)
+{
+    if (fixedNumFrames != variableNumFrames)
+        numFrames = fixedNumFrames;
+
+    LFO& channelLFO = (channel == 0) ? left_LFO1 : right_LFO1;
+    float depth = depthSamples[channel];
+    int currentInterval = getControlInterval(currentTier);
+    int previousInterval = getControlInterval(previousTier);
+    bool fading = tierFadeRemaining > 0;
+
+    // Evaluate the LFO for the whole sub-block and increment it
+    // While a tier change is in progress, the previous tier's LFO values are needed as well
+    channelLFO.getControlRateBlock(lfoScratch, numFrames, currentInterval);
+    if (fading)
+        channelLFO.getControlRateBlock(previousDelayScratch, numFrames, previousInterval);
+    channelLFO.incrementLFO(numFrames);
+
+    if (mirrorToRight)
+        right_LFO1.incrementLFO(numFrames);
+
+    // Calculate the number of samples of delay needed for the vibrato portion
+    // Track the largest delayChange, which is the shortest delay in the sub-block
+    for (int index = 0; index < numFrames; index++)
+        delayScratch[index] = getDelayChange(lfoScratch[index], depth);
+    float shortestDelayChange = juce::FloatVectorOperations::findMaximum(delayScratch, numFrames);
+
+    if (fading)
+    {
+        for (int index = 0; index < numFrames; index++)
+            previousDelayScratch[index] = getDelayChange(previousDelayScratch[index], depth);
+        shortestDelayChange = juce::jmax(shortestDelayChange, juce::FloatVectorOperations::findMaximum(previousDelayScratch, numFrames));
+    }
+
+    float* channelRegen = regenScratch[channel];
+
+    // Cubic interpolation reads one sample newer than linear interpolation
+    bool usesCubic = currentTier == QualityTier::High || (fading && previousTier == QualityTier::High);
+    int readGuard = usesCubic ? 1 : 0;
+
+    // When the shortest delay spans the whole sub-block, no read depends on a regeneration write
+    // from the same sub-block, so reading, mixing and writing run as independent loops
+    if ((int)(-shortestDelayChange) >= numFrames + readGuard)
+    {
+        readDelayBlock(currentTier, delayScratch, delayedScratch, numFrames, channel);
+
+        // Crossfade from the previous tier while a tier change is in progress
+        if (fading)
+        {
+            readDelayBlock(previousTier, previousDelayScratch, previousDelayedScratch, numFrames, channel);
+
+            int fadeFrames = juce::jmin(numFrames, tierFadeRemaining);
+            for (int index = 0; index < fadeFrames; index++)
             {
-                delayChange = -1.0f * delayMinimum - ( (float)depthRightSamples / 2.0f ) * (1.0f + (float)right_LFO1.getCurrentValue());
-                right_LFO1.incrementLFO();
+                float fadeOut = (float)(tierFadeRemaining - index) / (float)tierFadeLength;
+                delayedScratch[index] = (1.0f - fadeOut) * delayedScratch[index] + fadeOut * previousDelayedScratch[index];
             }
+        }
+
+        // Calculate output values and regeneration values to place back into the delay line
+        for (int index = 0; index < numFrames; index++)
+        {
+            float bufferSample = channelData[index];
+            channelData[index] = dryGain * bufferSample + wetGain * delayedScratch[index];
+            channelRegen[index] = regenDryGain * bufferSample + regenWetGain * delayedScratch[index];
+        }
+
+        simpleDelay.setBlock(channelRegen, numFrames, channel);
+        if (mirrorToRight)
+            simpleDelay.setBlock(channelRegen, numFrames, 1);
+        return;
+    }
+
+    // Very short delays read samples written earlier in the same sub-block,
+    // so fall back to processing one sample at a time
+    int fadeRemaining = tierFadeRemaining;
+
+    // Loop over indices in the sub-block
+    for (int index = 0; index < numFrames; index++)
+    {
+        // Retrieve samples from the delay line and the input buffer
+        // Crossfade from the previous tier while a tier change is in progress
+        float delaySample = readDelayLine(currentTier, delayScratch[index], channel);
+        if (fadeRemaining > 0)
+        {
+            float fadeOut = (float)fadeRemaining / (float)tierFadeLength;
+            delaySample = (1.0f - fadeOut) * delaySample + fadeOut * readDelayLine(previousTier, previousDelayScratch[index], channel);
+            fadeRemaining--;
+        }
+        float bufferSample = channelData[index];
+
+        // Calculate output value and regeneration value to place back into the delay line
+        float newValue = dryGain * bufferSample + wetGain * delaySample;
+        float regenValue = regenDryGain * bufferSample + regenWetGain * delaySample;
+
+        // Replace the delay line head value and increment the delay line
+        simpleDelay.setSample(regenValue, channel);
+        simpleDelay.incrementDelay(channel);
+        if (mirrorToRight)
+        {
+            simpleDelay.setSample(regenValue, 1);
+            simpleDelay.incrementDelay(1);
+        }
+        channelRegen[index] = regenValue;
+
+        // Place the output value back in the buffer
+        channelData[index] = newValue;
+    }
+}
+
+void MyPlugInAudioProcessor::setParameterAsync(ParameterId id, float value)
+{
+    // Publish the value before flagging it as pending
+    pendingParameterValues[(int)id].store(value, std::memory_order_relaxed);
+    pendingParameterMask.fetch_or(1u << (int)id, std::memory_order_release);
+}
+
+bool MyPlugInAudioProcessor::queueParameterEvent(int sampleOffset, ParameterId id, float value)
+{
+    return addBlockEvent({ sampleOffset, id, value });
+}
+
+void MyPlugInAudioProcessor::setParameterFromEditor(ParameterId id, float value)
+{
+    juce::AudioParameterFloat* parameter = hostParameters[(int)id];
+    parameter->setValueNotifyingHost(parameter->convertTo0to1(getParameterRange(id).clipValue(value)));
+}
+
+void MyPlugInAudioProcessor::beginParameterGesture(ParameterId id)
+{
+    hostParameters[(int)id]->beginChangeGesture();
+}
+
+void MyPlugInAudioProcessor::endParameterGesture(ParameterId id)
+{
+    hostParameters[(int)id]->endChangeGesture();
+}
+
+void MyPlugInAudioProcessor::parameterValueChanged(int parameterIndex, float newValue)
+{
+    if (parameterIndex < 0 || parameterIndex >= (int)ParameterId::NumParameters)
+        return;
+
+    // newValue is normalised to 0..1
+    setParameterAsync((ParameterId)parameterIndex, hostParameters[parameterIndex]->convertFrom0to1(newValue));
+}
+
+void MyPlugInAudioProcessor::parameterGestureChanged(int parameterIndex, bool gestureIsStarting)
+{
+    juce::ignoreUnused(parameterIndex, gestureIsStarting);
+}
+
+void MyPlugInAudioProcessor::addHostParameter(ParameterId id, const juce::String& parameterID, const juce::String& name, float interval)
+{
+    jassert((int)getParameters().size() == (int)id);
+
+    juce::Range<float> range = getParameterRange(id);
+    auto* parameter = new juce::AudioParameterFloat(parameterID, name,
+                                                    juce::NormalisableRange<float>(range.getStart(), range.getEnd(), interval),
+                                                    getParameterValue(id));
+    parameter->addListener(this);
+    addParameter(parameter);
+    hostParameters[(int)id] = parameter;
+}
+
+void MyPlugInAudioProcessor::setMidiControllerMapping(int controllerNumber, ParameterId id, float minimum, float maximum)
+{
+    if (controllerNumber < 0 || controllerNumber > 127)
+        return;
+
+    midiControllerMappings[controllerNumber] = { true, id, minimum, maximum };
+}
+
+void MyPlugInAudioProcessor::clearMidiControllerMapping(int controllerNumber)
+{
+    if (controllerNumber < 0 || controllerNumber > 127)
+        return;
+
+    midiControllerMappings[controllerNumber].active = false;
+}
+
+bool MyPlugInAudioProcessor::addBlockEvent(const ParameterEvent& event)
+{
+    if (numBlockEvents >= maxEventsPerBlock)
+        return false;
+
+    // Events mostly arrive in order, so insert from the back
+    // Events at the same position keep their arrival order
+    int position = numBlockEvents;
+    while (position > 0 && blockEvents[position - 1].sampleOffset > event.sampleOffset)
+    {
+        blockEvents[position] = blockEvents[position - 1];
+        position--;
+    }
+
+    blockEvents[position] = event;
+    numBlockEvents++;
+    return true;
+}
+
+void MyPlugInAudioProcessor::collectMidiEvents(const juce::MidiBuffer& midiMessages)
+{
+    for (const auto metadata : midiMessages)
+    {
+        const auto message = metadata.getMessage();
+        if (!message.isController())
+            continue;
+
+        const MidiControllerMapping& mapping = midiControllerMappings[message.getControllerNumber()];
+        if (!mapping.active)
+            continue;
+
+        float value = mapping.minimum + (mapping.maximum - mapping.minimum) * (float)message.getControllerValue() / 127.0f;
+        addBlockEvent({ metadata.samplePosition, mapping.id, value });
+    }
+}
+
+void MyPlugInAudioProcessor::updateDerivedParameters()
+{
+    // Convert the vibrato's frequency ratio into a number of samples
+    depthSamples[0] = 48000.0f * (((float)f_ratio - 1.0f) / (float)(2.0f * M_PI * (float)left_LFO1.getFrequency()));
+    depthSamples[1] = 48000.0f * (((float)f_ratio - 1.0f) / (float)(2.0f * M_PI * (float)right_LFO1.getFrequency()));
 
-            // Retrieve samples from the delay line and the input buffer
-            delaySample = simpleDelay.getSample(delayChange, channel);
-            bufferSample = *buffer.getReadPointer(channel, index);
+    dryGain = 1.0f - (float)delayGain;
+    wetGain = (float)delayGain;
+    regenDryGain = 1.0f - (float)regenGain;
+    regenWetGain = (float)regenGain;
+}
+
+void MyPlugInAudioProcessor::applyPendingParameters()
+{
+    juce::uint32 pending = pendingParameterMask.exchange(0, std::memory_order_acquire);
+    if (pending == 0)
+        return;
+
+    for (int index = 0; pending != 0; index++, pending >>= 1)
+    {
+        if (pending & 1u)
+            applyParameter((ParameterId)index, pendingParameterValues[index].load(std::memory_order_relaxed));
+    }
 
-            // Calculate output value and regeneration value to place back into the delay line
-            newValue = ( 1.0f - (float)delayGain) * (float)bufferSample + (float)delayGain * (float)delaySample ;
-            regenValue = (1.0f - (float)regenGain) * (float)bufferSample + (float)regenGain * (float)delaySample ;
+    updateCascadeStages();
+}
 
-            // Replace the delay line head value and increment the delay line
-            simpleDelay.setSample(regenValue, channel);
-            simpleDelay.incrementDelay(channel);
+float MyPlugInAudioProcessor::getParameterValue(ParameterId id)
+{
+    float value = currentParameterValues[(int)id].load(std::memory_order_relaxed);
 
-            // Place the output value back in the buffer
-            channelData[index] = newValue;
+    // A change the audio thread has not applied yet is more recent, once clamped as applyParameter will
+    if ((pendingParameterMask.load(std::memory_order_acquire) & (1u << (int)id)) != 0)
+    {
+        float pendingValue = pendingParameterValues[(int)id].load(std::memory_order_relaxed);
+        if (std::isfinite(pendingValue))
+            value = getParameterRange(id).clipValue(pendingValue);
+    }
+
+    return value;
+}
+
+juce::Range<float> MyPlugInAudioProcessor::getParameterRange(ParameterId id)
+{
+    switch (id)
+    {
+        case ParameterId::Depth:
+            return { 1.0f, 1.059f };
+        case ParameterId::Rate:
+            return { 0.1f, 9.0f };
+        case ParameterId::Delay:
+        {
+            // Deepest modulation, at the largest frequency ratio and the lowest rate, computed as in updateDerivedParameters
+            float maxDepth = 48000.0f * ((getParameterRange(ParameterId::Depth).getEnd() - 1.0f)
+                                         / (float)(2.0f * M_PI * getParameterRange(ParameterId::Rate).getStart()));
+            // The 48000 sample delay line also needs two samples for interpolation and one for rounding
+            return { 1.0f, std::floor(48000.0f - 3.0f - maxDepth) };
         }
-     
+        case ParameterId::PhaseOffset:
+            return { 0.0f, 180.0f };
+        case ParameterId::DelayGain:
+            return { 0.0f, 1.0f };
+        case ParameterId::RegenGain:
+            return { 0.0f, 0.95f };
+        case ParameterId::CascadeStages:
+            return { 1.0f, (float)(FlangerCascade::maxExtraStages + 1) };
+        case ParameterId::CascadeRateSpread:
+            return { 1.0f, 2.0f };
+        default:
+            return { 0.0f, 0.0f };
+    }
+}
+
+void MyPlugInAudioProcessor::applyParameter(ParameterId id, float value)
+{
+    // Values from the daemon, MIDI or other callers may be anywhere, and a delay or rate
+    // out of range would read outside the delay line or stop the LFO
+    if (!std::isfinite(value))
+        return;
+
+    value = getParameterRange(id).clipValue(value);
+
+    switch (id)
+    {
+        case ParameterId::Depth:
+            f_ratio = value;
+            cascadeModulationChanged = true;
+            break;
+        case ParameterId::Rate:
+            left_LFO1.resetFrequency(value);
+            right_LFO1.resetFrequency(value);
+            cascadeModulationChanged = true;
+            break;
+        case ParameterId::Delay:
+            delayMinimum = (int)value;
+            value = (float)delayMinimum;
+            cascadeModulationChanged = true;
+            break;
+        case ParameterId::PhaseOffset:
+            right_LFO1.setPhaseOffset(value * (float)M_PI / 180.0f);
+            cascadeModulationChanged = true;
+            break;
+        case ParameterId::DelayGain:
+            delayGain = value;
+            cascadeGainsChanged = true;
+            break;
+        case ParameterId::RegenGain:
+            regenGain = value;
+            cascadeGainsChanged = true;
+            break;
+        case ParameterId::CascadeStages:
+            // New stages pick up the current settings
+            updateCascadeStages();
+            cascade->setNumExtraStages((int)value - 1, left_LFO1, right_LFO1);
+            value = (float)(cascade->getNumExtraStages() + 1);
+            break;
+        case ParameterId::CascadeRateSpread:
+            cascadeRateSpread = value;
+            cascadeModulationChanged = true;
+            break;
+        default:
+            break;
     }
 
+    currentParameterValues[(int)id].store(value, std::memory_order_relaxed);
+}
+
+// Extra cascade stages follow this stage's settings
+void MyPlugInAudioProcessor::updateCascadeStages()
+{
+    if (cascadeModulationChanged)
+        cascade->setStageModulation(f_ratio, left_LFO1.getFrequency(), cascadeRateSpread, delayMinimum, right_LFO1.getPhaseOffset());
+
+    if (cascadeGainsChanged)
+        cascade->setStageGains(delayGain, regenGain);
+
+    cascadeModulationChanged = false;
+    cascadeGainsChanged = false;
+}
+
+float MyPlugInAudioProcessor::getDelayChange(float lfoValue, float depth)
+{
+    return -1.0f * delayMinimum - (depth / 2.0f) * (1.0f + lfoValue);
+}
+
+// Read the delay line with the interpolation order of a quality tier
+float MyPlugInAudioProcessor::readDelayLine(QualityTier tier, float delayChange, int channel)
+{
+    if (tier == QualityTier::High)
+        return simpleDelay.getCubicSample(delayChange, channel);
+
+    return simpleDelay.getLinearSample(delayChange, channel);
+}
+
+void MyPlugInAudioProcessor::readDelayBlock(QualityTier tier, const float* delayChanges, float* dest, int numFrames, int channel)
+{
+    if (tier == QualityTier::High)
+        simpleDelay.getCubicBlock(delayChanges, dest, numFrames, channel);
+    else
+        simpleDelay.getLinearBlock(delayChanges, dest, numFrames, channel);
 }
 
 //==============================================================================
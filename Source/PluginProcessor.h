@@ -16,8 +16,11 @@
 #define _USE_MATH_DEFINES
 
 #include <JuceHeader.h>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <math.h>
+#include <memory>
 #include <vector>
 
 
@@ -55,137 +58,95 @@ public:
     };
 
     // Returns a sample at fractional delay delayChange from channel lineSelect
-    // If the delay change is small, just return the zero-delay value
-    float getSample(float delayChange, int lineSelect)
+    // using linear interpolation on the index of the write head
+    float getLinearSample(float delayChange, int lineSelect)
     {
-        // Split delayChange into integer and fractional components
-        float intDelayf, fracDelay;
-        fracDelay = modf(delayChange, &intDelayf);
-        int intDelay = (int)intDelayf;
+        return interpolateLinear((lineSelect == 0) ? leftLine : rightLine, getHead(lineSelect), delayChange);
+    };
 
-        float x1 = 0;
+    // Returns a sample at fractional delay delayChange from channel lineSelect
+    // using 4-point cubic Hermite interpolation
+    float getCubicSample(float delayChange, int lineSelect)
+    {
+        return interpolateCubic((lineSelect == 0) ? leftLine : rightLine, getHead(lineSelect), delayChange);
+    };
 
-        // Left line
-        if (lineSelect == 0) 
-        {
-            x1 = *leftIter;
-            if ( abs(delayChange) < 0.1)
-                return x1;
-            else 
-            {
-                // Find the fractional delay
-                return getVariableDelay(intDelay, fracDelay, 0);
-            }
-        }
-        // Right line
-        else
-        {
-            x1 = *rightIter;
-            if (abs(delayChange) < 0.1)
-                return x1;
-            else
-            {
-                // Find the fractional delay
-                return getVariableDelay(intDelay, fracDelay, 1);
-            }
-        }
-            
+    // Block versions of getLinearSample and getCubicSample
+    // Frame k is read at delayChanges[k] relative to k samples past the write head,
+    // so every read must land on samples written before the current write head
+    // Only the frames whose reads wrap around either end of the line use the wrapping reads,
+    // the stretch in between reads the line directly
+    void getLinearBlock(const float* delayChanges, float* dest, int numFrames, int lineSelect)
+    {
+        std::vector<float>& line = (lineSelect == 0) ? leftLine : rightLine;
+        int head = getHead(lineSelect);
+        int unwrappedStart, unwrappedEnd;
+        getUnwrappedFrames(delayChanges, numFrames, head, 1, 0, unwrappedStart, unwrappedEnd);
+
+        for (int index = 0; index < unwrappedStart; index++)
+            dest[index] = interpolateLinear(line, head + index, delayChanges[index]);
+
+        readLinearUnwrapped(line.data() + head, delayChanges, dest, unwrappedStart, unwrappedEnd);
+
+        for (int index = unwrappedEnd; index < numFrames; index++)
+            dest[index] = interpolateLinear(line, head + index, delayChanges[index]);
     };
 
-    // Find the fractional delay
-    float getVariableDelay(int intDelay, float fracDelay, int channel) {
-        
-        float returnVal = 0.0f;
+    void getCubicBlock(const float* delayChanges, float* dest, int numFrames, int lineSelect)
+    {
+        std::vector<float>& line = (lineSelect == 0) ? leftLine : rightLine;
+        int head = getHead(lineSelect);
+        int unwrappedStart, unwrappedEnd;
+        getUnwrappedFrames(delayChanges, numFrames, head, 2, 1, unwrappedStart, unwrappedEnd);
 
-        // Left Channel
-        if (channel == 0)
-        {
-            // The delay amount is greater than zero.
-            // Should never happen but here as a failsafe.
-            if (intDelay >= 0)
-            {
-                // Positive delay goes past the end of the array
-                if (intDelay >= (leftLine.end() - leftIter))
-                {
-                    returnVal = leftLine.at(intDelay - (leftLine.end() - leftIter)) * (1 - fracDelay) + leftLine.at(intDelay - (leftLine.end() - leftIter)) * fracDelay;
-                }
-                // Positive delay is at the very end of the array
-                else if ((leftIter + intDelay) == leftLine.end() - 1 || (leftIter + intDelay) == leftLine.end() - 2)
-                {
-                    returnVal = *(leftLine.end() - 1) * (1.0f - fracDelay) + *leftLine.begin() * fracDelay;
-                }
-                // Positive delay doesn't overlap
-                else {
-                    returnVal = *(leftIter + intDelay) * (1.0f - fracDelay) + *(leftIter + intDelay + 1) * fracDelay;
-                }
-            }
-            // The delay amount is less than zero
-            // This should almost always be the code that actually executes
-            else if (intDelay < 0)
-            {
-                // Negative delay doesnt overlap beginning of array
-                if (abs(intDelay) + 1 <= (leftIter - leftLine.begin()))
-                {
-                    returnVal = *(leftIter - abs(intDelay)) * (1.0f - abs(fracDelay)) + *(leftIter - (abs(intDelay) + 1)) * abs(fracDelay);
-                }
-                // Negative delay overlaps beginning of array
-                else if (abs(intDelay) > (leftIter - leftLine.begin()))
-                {
-                    returnVal = *(leftLine.end() - 1 - (abs(intDelay) - (leftIter - leftLine.begin()))) * (1.0f - abs(fracDelay)) + *(leftLine.end() - 2 - (abs(intDelay) - (leftIter - leftLine.begin()))) * abs(fracDelay);
-                }
-                // Negative delay is at very beginning of array
-                else {
-                    returnVal = *leftLine.begin() * (1.0f - abs(fracDelay)) + *(leftLine.end() - 1) * abs(fracDelay);
-                }
+        // Delays short enough to fall back to linear interpolation are read one frame at a time
+        if (juce::FloatVectorOperations::findMaximum(delayChanges, numFrames) > -2.0f)
+            unwrappedStart = unwrappedEnd = 0;
 
-            }
-        }
-        // Right Line
+        for (int index = 0; index < unwrappedStart; index++)
+            dest[index] = interpolateCubic(line, head + index, delayChanges[index]);
+
+        readCubicUnwrapped(line.data() + head, delayChanges, dest, unwrappedStart, unwrappedEnd);
+
+        for (int index = unwrappedEnd; index < numFrames; index++)
+            dest[index] = interpolateCubic(line, head + index, delayChanges[index]);
+    };
+
+    // Write numFrames samples starting at the write head of line lineSelect
+    // and move the write head past them
+    void setBlock(const float* samples, int numFrames, int lineSelect)
+    {
+        std::vector<float>& line = (lineSelect == 0) ? leftLine : rightLine;
+        int head = getHead(lineSelect);
+
+        // Split the write where it wraps around the end of the line
+        int firstPart = std::min(numFrames, length - head);
+        std::copy(samples, samples + firstPart, line.begin() + head);
+        std::copy(samples + firstPart, samples + numFrames, line.begin());
+
+        if (lineSelect == 0)
+            leftIter = line.begin() + wrapIndex(head + numFrames);
         else
-        {
-            // The delay amount is greater than zero.
-            // Should never happen but here as a failsafe.
-            if (intDelay >= 0)
-            {
-                // Positive delay goes past the end of the array
-                if (intDelay >= (rightLine.end() - rightIter))
-                {
-                    returnVal = rightLine.at(intDelay - (rightLine.end() - rightIter)) * (1 - fracDelay) + rightLine.at(intDelay - (rightLine.end() - rightIter)) * fracDelay;
-                }
-                // Positive delay is at the very end of the array
-                else if ((rightIter + intDelay) == rightLine.end() - 1 || (rightIter + intDelay) == rightLine.end() - 2)
-                {
-                    returnVal = *(rightLine.end() - 1) * (1.0f - fracDelay) + *rightLine.begin() * fracDelay;
-                }
-                // Positive delay doesn't overlap
-                else {
-                    returnVal = *(rightIter + intDelay) * (1.0f - fracDelay) + *(rightIter + intDelay + 1) * fracDelay;
-                }
-            }
-            // The delay amount is less than zero
-            // This should almost always be the code that actually executes
-            else if (intDelay < 0)
-            {
-                // Negative delay doesnt overlap beginning of array
-                if (abs(intDelay) + 1 <= (rightIter - rightLine.begin()))
-                {
-                    returnVal = *(rightIter - abs(intDelay)) * (1.0f - abs(fracDelay)) + *(rightIter - (abs(intDelay) + 1)) * abs(fracDelay);
-                }
-                // Negative delay overlaps beginning of array
-                else if (abs(intDelay) > (rightIter - rightLine.begin()))
-                {
-                    returnVal = *(rightLine.end() - 1 - (abs(intDelay) - (rightIter - rightLine.begin()))) * (1.0f - abs(fracDelay)) + *(rightLine.end() - 2 - (abs(intDelay) - (rightIter - rightLine.begin()))) * abs(fracDelay);
-                }
-                // Negative delay is at very beginning of array
-                else {
-                    returnVal = *rightLine.begin() * (1.0f - abs(fracDelay)) + *(rightLine.end() - 1) * abs(fracDelay);
-                }
+            rightIter = line.begin() + wrapIndex(head + numFrames);
+    };
 
-            }
+    // Return the index of the write head of line lineSelect
+    int getHead(int lineSelect)
+    {
+        if (lineSelect == 0)
+            return (int)(leftIter - leftLine.begin());
 
-        }
+        return (int)(rightIter - rightLine.begin());
+    };
 
-        return returnVal;
+    // Wrap an index that is at most one length out of range back into the line
+    int wrapIndex(int index)
+    {
+        if (index < 0)
+            return index + length;
+        if (index >= length)
+            return index - length;
+        return index;
     };
 
     // Set the sample at the current iterator of line lineSelect to newSample
@@ -257,6 +218,93 @@ public:
     };
 
 private:
+    // Find the frames [start, end) of a block read whose samples all lie inside the line without wrapping
+    // olderReach and newerReach are how far the interpolation reads past the integer delay on either side
+    void getUnwrappedFrames(const float* delayChanges, int numFrames, int head, int olderReach, int newerReach, int& start, int& end)
+    {
+        juce::Range<float> delayChangeRange = juce::FloatVectorOperations::findMinAndMax(delayChanges, numFrames);
+        int longestDelay = (int)(-delayChangeRange.getStart());
+        int shortestDelay = (int)(-delayChangeRange.getEnd());
+
+        start = juce::jlimit(0, numFrames, longestDelay + olderReach - head);
+        end = juce::jlimit(start, numFrames, length - head + shortestDelay - newerReach);
+    };
+
+    // Linear interpolation for frames [start, end) of a block read that doesn't wrap
+    // data points at the write head and never overlaps dest
+    static void readLinearUnwrapped(const float* __restrict data, const float* __restrict delayChanges, float* __restrict dest, int start, int end)
+    {
+        for (int index = start; index < end; index++)
+        {
+            float delay = -delayChanges[index];
+            int intDelay = (int)delay;
+            float fracDelay = delay - (float)intDelay;
+            int newer = index - intDelay;
+
+            dest[index] = data[newer] * (1.0f - fracDelay) + data[newer - 1] * fracDelay;
+        }
+    };
+
+    // Cubic version of readLinearUnwrapped, for delays of at least 2 samples
+    static void readCubicUnwrapped(const float* __restrict data, const float* __restrict delayChanges, float* __restrict dest, int start, int end)
+    {
+        for (int index = start; index < end; index++)
+        {
+            float delay = -delayChanges[index];
+            int intDelay = (int)delay;
+            float fracDelay = delay - (float)intDelay;
+            int newer = index - intDelay;
+
+            dest[index] = hermite(data[newer + 1], data[newer], data[newer - 1], data[newer - 2], fracDelay);
+        }
+    };
+
+    // Linear interpolation at delayChange relative to position (which may be up to one length past the end)
+    float interpolateLinear(const std::vector<float>& line, int position, float delayChange)
+    {
+        // Split the delay into integer and fractional components
+        float delay = -delayChange;
+        int intDelay = (int)delay;
+        float fracDelay = delay - (float)intDelay;
+
+        int newer = wrapIndex(position - intDelay);
+        int older = (newer == 0) ? length - 1 : newer - 1;
+
+        return line[newer] * (1.0f - fracDelay) + line[older] * fracDelay;
+    };
+
+    // 4-point cubic Hermite interpolation at delayChange relative to position
+    // Needs one more written sample newer than the read point than linear interpolation,
+    // so very short delays fall back to interpolateLinear
+    float interpolateCubic(const std::vector<float>& line, int position, float delayChange)
+    {
+        // Split the delay into integer and fractional components
+        float delay = -delayChange;
+        int intDelay = (int)delay;
+        float fracDelay = delay - (float)intDelay;
+
+        if (intDelay < 2)
+            return interpolateLinear(line, position, delayChange);
+
+        // Four neighbouring samples, newest first
+        float xm1 = line[wrapIndex(position - intDelay + 1)];
+        float x0 = line[wrapIndex(position - intDelay)];
+        float x1 = line[wrapIndex(position - intDelay - 1)];
+        float x2 = line[wrapIndex(position - intDelay - 2)];
+
+        return hermite(xm1, x0, x1, x2, fracDelay);
+    };
+
+    // 4-point cubic Hermite polynomial between x0 and x1 at fracDelay
+    static float hermite(float xm1, float x0, float x1, float x2, float fracDelay)
+    {
+        float c1 = 0.5f * (x1 - xm1);
+        float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+        float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+
+        return ((c3 * fracDelay + c2) * fracDelay + c1) * fracDelay + x0;
+    };
+
     // length of delay line
     int length = 0;
     // Iterators for each channel
@@ -288,7 +336,75 @@ public:
     // Return the current value of the LFO
     float getCurrentValue()
     {
-        return cos( (2.0f * M_PI * (float)phaseStep * ( f_LFO / f_s ) ) + phaseOffset);
+        return getValueAt(phaseStep);
+    };
+
+    // Return the value of the LFO at an arbitrary phase step
+    float getValueAt(int step)
+    {
+        return cos( (2.0f * M_PI * (float)step * ( f_LFO / f_s ) ) + phaseOffset);
+    };
+
+    // Return the LFO value evaluated only once every controlInterval steps
+    // and linearly interpolated in between
+    // An interval of 1 is the same as getCurrentValue
+    float getControlRateValue(int controlInterval)
+    {
+        if (controlInterval <= 1)
+            return getCurrentValue();
+
+        int segmentStart = phaseStep - (phaseStep % controlInterval);
+
+        // Only evaluate the cosine when entering a new segment
+        if (segmentStart != cachedSegmentStart || controlInterval != cachedInterval)
+        {
+            segmentStartValue = getValueAt(segmentStart);
+            segmentEndValue = getValueAt(segmentStart + controlInterval);
+            cachedSegmentStart = segmentStart;
+            cachedInterval = controlInterval;
+        }
+
+        float position = (float)(phaseStep - segmentStart) / (float)controlInterval;
+        return segmentStartValue + (segmentEndValue - segmentStartValue) * position;
+    };
+
+    // Fill dest with the values getControlRateValue returns over the next numFrames steps
+    // without advancing the LFO
+    // numFrames must not be longer than one LFO period
+    void getControlRateBlock(float* dest, int numFrames, int controlInterval)
+    {
+        if (controlInterval <= 1)
+        {
+            for (int index = 0; index < numFrames; index++)
+                dest[index] = getValueAt(wrapStep(phaseStep + index));
+            return;
+        }
+
+        int index = 0;
+        while (index < numFrames)
+        {
+            int step = wrapStep(phaseStep + index);
+            int segmentStart = step - (step % controlInterval);
+
+            // Only evaluate the cosine when entering a new segment
+            if (segmentStart != cachedSegmentStart || controlInterval != cachedInterval)
+            {
+                segmentStartValue = getValueAt(segmentStart);
+                segmentEndValue = getValueAt(segmentStart + controlInterval);
+                cachedSegmentStart = segmentStart;
+                cachedInterval = controlInterval;
+            }
+
+            // Interpolate up to the end of the segment or the end of the period
+            int runLength = juce::jmin(numFrames - index, segmentStart + controlInterval - step, maxPhaseStep - step);
+            int segmentOffset = step - segmentStart;
+            for (int frame = 0; frame < runLength; frame++)
+            {
+                float position = (float)(segmentOffset + frame) / (float)controlInterval;
+                dest[index + frame] = segmentStartValue + (segmentEndValue - segmentStartValue) * position;
+            }
+            index += runLength;
+        }
     };
 
     // Set the frequency of the LFO
@@ -298,9 +414,10 @@ public:
         // Reset frequency and number of steps needed
         f_LFO = user_f_LFO;
         maxPhaseStep = (int)(f_s / f_LFO);
+        cachedSegmentStart = -1;
 
         // If phase is out of bounds, reset it
-        if (phaseStep >= maxPhaseStep - 1)
+        if (phaseStep >= maxPhaseStep)
         {
             phaseStep = 0;
         }
@@ -310,6 +427,7 @@ public:
     void setPhaseOffset(float user_phaseOffset)
     {
         phaseOffset = user_phaseOffset;
+        cachedSegmentStart = -1;
     };
 
     // Retrieve the phase offset in ratiance
@@ -338,7 +456,28 @@ public:
         }
     };
 
+    // Circularly increment the LFO by several steps at once
+    void incrementLFO(int steps)
+    {
+        phaseStep = (phaseStep + steps) % maxPhaseStep;
+    };
+
+    // Returns true if this LFO produces exactly the same values as other from now on
+    bool isInSyncWith(const LFO& other)
+    {
+        return phaseStep == other.phaseStep
+            && maxPhaseStep == other.maxPhaseStep
+            && f_LFO == other.f_LFO
+            && phaseOffset == other.phaseOffset;
+    };
+
 private:
+    // Wrap a phase step less than two periods long back into the first period
+    int wrapStep(int step)
+    {
+        return (step >= maxPhaseStep) ? step - maxPhaseStep : step;
+    };
+
     // Define members needed for operation
     int phaseStep = 0;
     int maxPhaseStep;
@@ -346,9 +485,152 @@ private:
     float f_LFO;
     // Sampling rate fixed to 48 kHz
     float f_s = 48000.0f;
+    // Cached segment end points for control-rate evaluation
+    int cachedSegmentStart = -1;
+    int cachedInterval = 0;
+    float segmentStartValue = 0.0f;
+    float segmentEndValue = 0.0f;
 };
 
-class MyPlugInAudioProcessor  : public juce::AudioProcessor
+/*
+    Processing quality tiers, cheapest first
+    Eco:      linear interpolation, LFO evaluated every 16 samples
+    Standard: linear interpolation, LFO evaluated every sample
+    High:     cubic interpolation, LFO evaluated every sample
+*/
+enum class QualityTier
+{
+    Eco = 0,
+    Standard,
+    High
+};
+
+// Number of samples between LFO evaluations for a quality tier
+inline int getControlInterval(QualityTier tier)
+{
+    return (tier == QualityTier::Eco) ? 16 : 1;
+}
+
+/*
+Class: QualityGovernor
+       Chooses the quality tier for each processed block
+       Offline rendering always runs at the highest tier
+       In real time, a moving average of processBlock time against the block deadline
+       steps the tier down under load and back up once there is headroom again
+       Smoothing and hold times are in seconds so they don't depend on the host block size
+*/
+class QualityGovernor
+{
+public:
+    // Highest tier allowed while running in real time
+    QualityTier maxRealtimeTier = QualityTier::Standard;
+
+    // Set the sample rate used to compute block deadlines
+    void setSampleRate(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        averageLoad = 0.0;
+    };
+
+    // Record how long the last block of numSamples took to process
+    void reportBlockTime(double elapsedSeconds, int numSamples)
+    {
+        if (numSamples <= 0 || sampleRate <= 0.0)
+            return;
+
+        // Fraction of the block deadline that was used, limited so one preempted block can't move the average on its own
+        double blockSeconds = (double)numSamples / sampleRate;
+        double load = juce::jmin(elapsedSeconds / blockSeconds, maxBlockLoad);
+        double smoothing = 1.0 - std::exp(-blockSeconds / loadTimeConstantSeconds);
+        averageLoad += smoothing * (load - averageLoad);
+        secondsSinceChange += blockSeconds;
+    };
+
+    // Return the tier to use for the next block
+    QualityTier chooseTier(bool isNonRealtime)
+    {
+        if (isNonRealtime)
+            return changeTier(QualityTier::High);
+
+        // Coming back from an offline render
+        if (tier > maxRealtimeTier)
+            return changeTier(maxRealtimeTier);
+
+        // Step down quickly under load
+        if (averageLoad > stepDownLoad && tier > QualityTier::Eco && secondsSinceChange >= stepDownHoldSeconds)
+            return changeTier((QualityTier)((int)tier - 1));
+
+        // Step up only after a sustained period of headroom
+        if (averageLoad < stepUpLoad && tier < maxRealtimeTier && secondsSinceChange >= stepUpHoldSeconds)
+            return changeTier((QualityTier)((int)tier + 1));
+
+        return tier;
+    };
+
+    // Return the moving average of the block load
+    double getAverageLoad()
+    {
+        return averageLoad;
+    };
+
+private:
+    // Switch tier and restart the hold counter
+    QualityTier changeTier(QualityTier newTier)
+    {
+        if (newTier != tier)
+        {
+            tier = newTier;
+            secondsSinceChange = 0.0;
+        }
+
+        return tier;
+    };
+
+    QualityTier tier = QualityTier::Standard;
+    double sampleRate = 48000.0;
+    double averageLoad = 0.0;
+    double secondsSinceChange = 0.0;
+    // Tuning for the moving average and the hysteresis between tiers
+    const double maxBlockLoad = 2.0;
+    const double loadTimeConstantSeconds = 0.2;
+    const double stepDownLoad = 0.7;
+    const double stepUpLoad = 0.35;
+    const double stepDownHoldSeconds = 0.2;
+    const double stepUpHoldSeconds = 1.5;
+};
+
+/*
+    Parameters that can be changed from other threads with setParameterAsync
+    Units match the editor: depth is the frequency ratio, rate in Hz, delay in samples,
+    phase offset in degrees, gains linear
+*/
+enum class ParameterId
+{
+    Depth = 0,
+    Rate,
+    Delay,
+    PhaseOffset,
+    DelayGain,
+    RegenGain,
+    // Number of cascaded flanger stages, 1 to 4
+    CascadeStages,
+    // Ratio between the LFO rates of successive cascade stages, 1 to share one LFO
+    CascadeRateSpread,
+    NumParameters
+};
+
+// A parameter change at a sample position within a block, value in the units of ParameterId
+struct ParameterEvent
+{
+    int sampleOffset = 0;
+    ParameterId id = ParameterId::Depth;
+    float value = 0.0f;
+};
+
+class FlangerCascade;
+
+class MyPlugInAudioProcessor  : public juce::AudioProcessor,
+                                private juce::AudioProcessorParameter::Listener
 {
 public:
     // Define variables needed for access by both the Editor (GUI) and the processor itself
@@ -365,6 +647,55 @@ public:
     LFO left_LFO1 = LFO(left_LFO1_frequency);
     LFO right_LFO1 = LFO(right_LFO1_frequency);
 
+    // Change a parameter from any thread other than the audio thread
+    // The change is applied at the start of the next processBlock without locking
+    // If a parameter changes several times in between, only the latest value is applied
+    // Values are clamped to getParameterRange and non-finite values are ignored, whichever way they arrive
+    void setParameterAsync(ParameterId id, float value);
+
+    // Return the latest value of a parameter, including changes the audio thread has not picked up yet
+    // Can be called from any thread, e.g. by the editor to show the current settings
+    float getParameterValue(ParameterId id);
+
+    // Return the range of values a parameter can take
+    // The delay range leaves room for the deepest modulation and the interpolation inside simpleDelay
+    static juce::Range<float> getParameterRange(ParameterId id);
+
+    // Schedule a parameter change sampleOffset samples into the next processBlock
+    // Call from the thread that calls processBlock, before the block
+    // This is an API for the streaming daemon or a custom wrapper that has timestamped automation:
+    // plugin hosts automate the registered host parameters instead, whose changes are applied
+    // at the start of the next block like setParameterAsync
+    // Returns false if the block's event list is full
+    bool queueParameterEvent(int sampleOffset, ParameterId id, float value);
+
+    // Change a parameter from the editor
+    // Goes through the host parameter, so the host sees the change and can record it as automation
+    void setParameterFromEditor(ParameterId id, float value);
+    // Mark the start and end of an editor change, e.g. while a slider is dragged
+    void beginParameterGesture(ParameterId id);
+    void endParameterGesture(ParameterId id);
+
+    // Map MIDI continuous controller controllerNumber onto a parameter, scaling 0..127 to minimum..maximum
+    // CC values in the MIDI input of processBlock then change the parameter at the message's sample position
+    // Defaults: CC 1 depth, CC 20 rate, CC 21 delay, CC 22 delay gain, CC 23 regeneration gain
+    // Plugin builds only receive MIDI with JucePlugin_WantsMidiInput set in the project settings
+    // Call while the processor is not processing
+    void setMidiControllerMapping(int controllerNumber, ParameterId id, float minimum, float maximum);
+    void clearMidiControllerMapping(int controllerNumber);
+
+    // Return the extra cascade stages, e.g. for tests
+    FlangerCascade& getCascade()
+    {
+        return *cascade;
+    };
+
+    // Returns true if the last sub-block was processed once for both channels in dual-mono mode, e.g. for tests
+    bool wasLastSubBlockDualMono()
+    {
+        return lastSubBlockDualMono;
+    };
+
     //==============================================================================
     MyPlugInAudioProcessor();
     ~MyPlugInAudioProcessor() override;
@@ -403,6 +734,113 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
 
 private:
+    // Host parameter changes, from automation, the host's own controls or the editor,
+    // are handed to the audio thread through setParameterAsync
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override;
+    // Register the host parameter for id, with the range of getParameterRange
+    // Parameters are added in ParameterId order, so a parameter's index is its ParameterId
+    void addHostParameter(ParameterId id, const juce::String& parameterID, const juce::String& name, float interval);
+
+    // Parameters the host can automate, owned by the AudioProcessor
+    // They only follow changes made through them, not changes from MIDI or setParameterAsync
+    juce::AudioParameterFloat* hostParameters[(int)ParameterId::NumParameters] = {};
+
+    // Apply a parameter change on the audio thread
+    void applyParameter(ParameterId id, float value);
+    // Apply every change queued by setParameterAsync since the last block
+    void applyPendingParameters();
+
+    // Latest value of each parameter set through setParameterAsync,
+    // with one bit per parameter in pendingParameterMask marking values not yet applied
+    std::atomic<float> pendingParameterValues[(int)ParameterId::NumParameters];
+    std::atomic<juce::uint32> pendingParameterMask { 0 };
+    // Value of each parameter as last applied on the audio thread, for getParameterValue
+    std::atomic<float> currentParameterValues[(int)ParameterId::NumParameters];
+
+    // Add an event to the current block's event list, keeping it sorted by sample offset
+    bool addBlockEvent(const ParameterEvent& event);
+    // Add an event for every mapped MIDI controller message in midiMessages
+    void collectMidiEvents(const juce::MidiBuffer& midiMessages);
+    // Recompute the values derived from the parameters: depth in samples and mixing gains
+    // Called at the start of each block and after each group of events only
+    void updateDerivedParameters();
+
+    // Process samples startSample to endSample of every channel in sub-blocks
+    void processRange(juce::AudioBuffer<float>& buffer, int numInputChannels, int startSample, int endSample);
+    // Process numFrames (at most subBlockSize) frames of every channel starting at startSample
+    // Full sub-blocks use fixedNumFrames = subBlockSize, so the loop trip count is a compile-time constant
+    // The remainder of a block uses variableNumFrames and takes its length from numFrames
+    template <int fixedNumFrames>
+    void processSubBlock(juce::AudioBuffer<float>& buffer, int numInputChannels, int startSample, int numFrames);
+    // Process one channel of a sub-block in place
+    // With mirrorToRight, the regeneration writes and LFO steps are applied to the right channel as well
+    template <int fixedNumFrames>
+    void processChannelSubBlock(float* channelData, int channel, int numFrames, bool mirrorToRight);
+    static constexpr int variableNumFrames = 0;
+    // Pass settings changed since the last call on to the extra cascade stages
+    void updateCascadeStages();
+    // Return the delay (as a negative number of samples) for an LFO value
+    float getDelayChange(float lfoValue, float depth);
+    // Read the delay line at delayChange with the interpolation of quality tier
+    float readDelayLine(QualityTier tier, float delayChange, int channel);
+    // Read one delayed sample per frame of a sub-block with the interpolation of quality tier
+    void readDelayBlock(QualityTier tier, const float* delayChanges, float* dest, int numFrames, int channel);
+
+    // Host buffers are processed in fixed-size sub-blocks
+    // The scratch arrays below are small enough to stay resident in L1
+    static constexpr int subBlockSize = 32;
+    float delayScratch[subBlockSize];
+    float previousDelayScratch[subBlockSize];
+    float delayedScratch[subBlockSize];
+    float previousDelayedScratch[subBlockSize];
+    float regenScratch[2][subBlockSize];
+    // LFO values of the channel being processed, shared with cascade stages at the same rate
+    float lfoScratch[subBlockSize];
+    // Modulation depth in samples for each channel and the mixing gains,
+    // updated by updateDerivedParameters
+    float depthSamples[2] = { 0.0f, 0.0f };
+    float dryGain = 0.2f;
+    float wetGain = 0.8f;
+    float regenDryGain = 1.0f;
+    float regenWetGain = 0.0f;
+
+    // Timestamped parameter events of the next or current block, sorted by sample offset
+    static constexpr int maxEventsPerBlock = 256;
+    ParameterEvent blockEvents[maxEventsPerBlock];
+    int numBlockEvents = 0;
+
+    // MIDI controller number to parameter mapping
+    struct MidiControllerMapping
+    {
+        bool active = false;
+        ParameterId id = ParameterId::Depth;
+        float minimum = 0.0f;
+        float maximum = 1.0f;
+    };
+    MidiControllerMapping midiControllerMappings[128];
+
+    // Dual-mono detection
+    // Counts consecutive frames in which both channels had identical input and settings
+    // and wrote identical regeneration values. Once it covers the delay line length,
+    // both lines hold the same contents and the right channel can copy the left
+    int matchingFramesRun = 0;
+    bool lastSubBlockDualMono = false;
+
+    // Extra flanger stages in series after this one
+    std::unique_ptr<FlangerCascade> cascade;
+    float cascadeRateSpread = 1.0f;
+    // Set by applyParameter for the cascade settings that updateCascadeStages has to pass on
+    bool cascadeModulationChanged = true;
+    bool cascadeGainsChanged = true;
+
+    // Quality tier selection and crossfading between tiers
+    QualityGovernor qualityGovernor;
+    QualityTier currentTier = QualityTier::Standard;
+    QualityTier previousTier = QualityTier::Standard;
+    int tierFadeRemaining = 0;
+    static constexpr int tierFadeLength = 512;
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MyPlugInAudioProcessor)
 };
@@ -0,0 +1,371 @@
+/*
+  ==============================================================================
+    Purpose: Real-Time Safety Sanitizer
+
+    The interposed functions below are only compiled when MYPLUGIN_RT_SANITIZER is set.
+    Each one checks whether the calling thread is inside a real-time scope and
+    then forwards to the real implementation.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "RealtimeSanitizer.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+   #if defined(__GNUC__)
+    // Initial-exec TLS never allocates on first access, which matters inside malloc itself
+    thread_local int realtimeDepth __attribute__((tls_model("initial-exec"))) = 0;
+    thread_local bool reportingViolation __attribute__((tls_model("initial-exec"))) = false;
+   #else
+    thread_local int realtimeDepth = 0;
+    thread_local bool reportingViolation = false;
+   #endif
+
+    std::atomic<int> sanitizerMode { (int)RealtimeSanitizer::Mode::Record };
+    std::atomic<int> violationCount { 0 };
+    RealtimeSanitizer::Violation recordedViolations[RealtimeSanitizer::maxRecordedViolations];
+}
+
+//==============================================================================
+RealtimeSanitizer::ScopedRealtimeContext::ScopedRealtimeContext()
+{
+    realtimeDepth++;
+}
+
+RealtimeSanitizer::ScopedRealtimeContext::~ScopedRealtimeContext()
+{
+    realtimeDepth--;
+}
+
+void RealtimeSanitizer::setMode(Mode newMode)
+{
+    sanitizerMode = (int)newMode;
+}
+
+RealtimeSanitizer::Mode RealtimeSanitizer::getMode()
+{
+    return (Mode)sanitizerMode.load();
+}
+
+bool RealtimeSanitizer::isInRealtimeScope()
+{
+    return realtimeDepth > 0;
+}
+
+void RealtimeSanitizer::checkRealtime(ViolationKind kind, const char* function)
+{
+    // Ignore anything the reporting below does itself
+    if (realtimeDepth == 0 || reportingViolation)
+        return;
+
+    reportingViolation = true;
+
+    int index = violationCount.fetch_add(1);
+    if (index < maxRecordedViolations)
+    {
+        recordedViolations[index].kind = kind;
+        recordedViolations[index].function = function;
+    }
+
+    if (getMode() == Mode::Abort)
+    {
+        std::fprintf(stderr, "Real-time safety violation: %s in %s\n", getKindName(kind), function);
+        std::fputs(juce::SystemStats::getStackBacktrace().toRawUTF8(), stderr);
+        std::fflush(stderr);
+        std::abort();
+    }
+
+    reportingViolation = false;
+}
+
+int RealtimeSanitizer::getNumViolations()
+{
+    return violationCount.load();
+}
+
+RealtimeSanitizer::Violation RealtimeSanitizer::getViolation(int index)
+{
+    if (index < 0 || index >= juce::jmin(getNumViolations(), (int)maxRecordedViolations))
+        return {};
+
+    return recordedViolations[index];
+}
+
+void RealtimeSanitizer::clearViolations()
+{
+    violationCount = 0;
+}
+
+const char* RealtimeSanitizer::getKindName(ViolationKind kind)
+{
+    switch (kind)
+    {
+        case ViolationKind::Allocation:     return "allocation";
+        case ViolationKind::Deallocation:   return "deallocation";
+        case ViolationKind::MutexLock:      return "mutex lock";
+        case ViolationKind::BlockingCall:   return "blocking call";
+        default:                            return "unknown";
+    }
+}
+
+#if MYPLUGIN_RT_SANITIZER
+
+//==============================================================================
+// Heap access that bypasses the interposed malloc/free, so each operation is reported once
+#if defined(__GLIBC__)
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void __libc_free(void*);
+}
+#endif
+
+namespace
+{
+    void* rawAllocate(std::size_t size)
+    {
+       #if defined(__GLIBC__)
+        return __libc_malloc(size == 0 ? 1 : size);
+       #else
+        return std::malloc(size == 0 ? 1 : size);
+       #endif
+    }
+
+    void rawFree(void* pointer)
+    {
+       #if defined(__GLIBC__)
+        __libc_free(pointer);
+       #else
+        std::free(pointer);
+       #endif
+    }
+
+    void* rawAllocateAligned(std::size_t size, std::size_t alignment)
+    {
+       #if defined(_WIN32)
+        return _aligned_malloc(size == 0 ? 1 : size, alignment);
+       #else
+        void* pointer = nullptr;
+        if (posix_memalign(&pointer, juce::jmax(alignment, sizeof(void*)), size == 0 ? 1 : size) != 0)
+            return nullptr;
+        return pointer;
+       #endif
+    }
+
+    void rawFreeAligned(void* pointer)
+    {
+       #if defined(_WIN32)
+        _aligned_free(pointer);
+       #else
+        rawFree(pointer);
+       #endif
+    }
+
+    void* checkedAllocate(std::size_t size, const char* function)
+    {
+        RealtimeSanitizer::checkRealtime(RealtimeSanitizer::ViolationKind::Allocation, function);
+        return rawAllocate(size);
+    }
+
+    void checkedFree(void* pointer, const char* function)
+    {
+        if (pointer != nullptr)
+            RealtimeSanitizer::checkRealtime(RealtimeSanitizer::ViolationKind::Deallocation, function);
+        rawFree(pointer);
+    }
+
+    void* checkedAllocateAligned(std::size_t size, std::align_val_t alignment, const char* function)
+    {
+        RealtimeSanitizer::checkRealtime(RealtimeSanitizer::ViolationKind::Allocation, function);
+        return rawAllocateAligned(size, (std::size_t)alignment);
+    }
+
+    void checkedFreeAligned(void* pointer, const char* function)
+    {
+        if (pointer != nullptr)
+            RealtimeSanitizer::checkRealtime(RealtimeSanitizer::ViolationKind::Deallocation, function);
+        rawFreeAligned(pointer);
+    }
+}
+
+//==============================================================================
+// Replacement global operator new and delete
+void* operator new (std::size_t size)
+{
+    if (void* pointer = checkedAllocate(size, "operator new"))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    if (void* pointer = checkedAllocate(size, "operator new[]"))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept
+{
+    return checkedAllocate(size, "operator new");
+}
+
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept
+{
+    return checkedAllocate(size, "operator new[]");
+}
+
+void* operator new (std::size_t size, std::align_val_t alignment)
+{
+    if (void* pointer = checkedAllocateAligned(size, alignment, "operator new"))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size, std::align_val_t alignment)
+{
+    if (void* pointer = checkedAllocateAligned(size, alignment, "operator new[]"))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete (void* pointer) noexcept                                   { checkedFree(pointer, "operator delete"); }
+void operator delete[] (void* pointer) noexcept                                 { checkedFree(pointer, "operator delete[]"); }
+void operator delete (void* pointer, std::size_t) noexcept                      { checkedFree(pointer, "operator delete"); }
+void operator delete[] (void* pointer, std::size_t) noexcept                    { checkedFree(pointer, "operator delete[]"); }
+void operator delete (void* pointer, const std::nothrow_t&) noexcept            { checkedFree(pointer, "operator delete"); }
+void operator delete[] (void* pointer, const std::nothrow_t&) noexcept          { checkedFree(pointer, "operator delete[]"); }
+void operator delete (void* pointer, std::align_val_t) noexcept                 { checkedFreeAligned(pointer, "operator delete"); }
+void operator delete[] (void* pointer, std::align_val_t) noexcept               { checkedFreeAligned(pointer, "operator delete[]"); }
+void operator delete (void* pointer, std::size_t, std::align_val_t) noexcept    { checkedFreeAligned(pointer, "operator delete"); }
+void operator delete[] (void* pointer, std::size_t, std::align_val_t) noexcept  { checkedFreeAligned(pointer, "operator delete[]"); }
+
+//==============================================================================
+// malloc family, mutex locks and blocking calls (Linux with glibc)
+#if defined(__GLIBC__)
+
+#include <dlfcn.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/select.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace
+{
+    // Look up the next definition of name after this one, once
+    template <typename FunctionType>
+    FunctionType findNext(std::atomic<void*>& cached, const char* name)
+    {
+        void* function = cached.load(std::memory_order_relaxed);
+        if (function == nullptr)
+        {
+            function = dlsym(RTLD_NEXT, name);
+            cached.store(function, std::memory_order_relaxed);
+        }
+
+        return (FunctionType)function;
+    }
+
+    std::atomic<void*> nextMutexLock { nullptr };
+    std::atomic<void*> nextNanosleep { nullptr };
+    std::atomic<void*> nextUsleep { nullptr };
+    std::atomic<void*> nextSleep { nullptr };
+    std::atomic<void*> nextRead { nullptr };
+    std::atomic<void*> nextWrite { nullptr };
+    std::atomic<void*> nextPoll { nullptr };
+    std::atomic<void*> nextSelect { nullptr };
+
+    void checkBlocking(const char* function)
+    {
+        RealtimeSanitizer::checkRealtime(RealtimeSanitizer::ViolationKind::BlockingCall, function);
+    }
+}
+
+extern "C"
+{
+    void* malloc(size_t size)
+    {
+        RealtimeSanitizer::checkRealtime(RealtimeSanitizer::ViolationKind::Allocation, "malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        RealtimeSanitizer::checkRealtime(RealtimeSanitizer::ViolationKind::Allocation, "calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size)
+    {
+        RealtimeSanitizer::checkRealtime(RealtimeSanitizer::ViolationKind::Allocation, "realloc");
+        return __libc_realloc(pointer, size);
+    }
+
+    void free(void* pointer)
+    {
+        if (pointer != nullptr)
+            RealtimeSanitizer::checkRealtime(RealtimeSanitizer::ViolationKind::Deallocation, "free");
+        __libc_free(pointer);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        RealtimeSanitizer::checkRealtime(RealtimeSanitizer::ViolationKind::MutexLock, "pthread_mutex_lock");
+        return findNext<int (*)(pthread_mutex_t*)>(nextMutexLock, "pthread_mutex_lock")(mutex);
+    }
+
+    int nanosleep(const struct timespec* duration, struct timespec* remaining)
+    {
+        checkBlocking("nanosleep");
+        return findNext<int (*)(const struct timespec*, struct timespec*)>(nextNanosleep, "nanosleep")(duration, remaining);
+    }
+
+    int usleep(useconds_t microseconds)
+    {
+        checkBlocking("usleep");
+        return findNext<int (*)(useconds_t)>(nextUsleep, "usleep")(microseconds);
+    }
+
+    unsigned int sleep(unsigned int seconds)
+    {
+        checkBlocking("sleep");
+        return findNext<unsigned int (*)(unsigned int)>(nextSleep, "sleep")(seconds);
+    }
+
+    ssize_t read(int fd, void* buffer, size_t count)
+    {
+        checkBlocking("read");
+        return findNext<ssize_t (*)(int, void*, size_t)>(nextRead, "read")(fd, buffer, count);
+    }
+
+    ssize_t write(int fd, const void* buffer, size_t count)
+    {
+        checkBlocking("write");
+        return findNext<ssize_t (*)(int, const void*, size_t)>(nextWrite, "write")(fd, buffer, count);
+    }
+
+    int poll(struct pollfd* fds, nfds_t numFds, int timeout)
+    {
+        checkBlocking("poll");
+        return findNext<int (*)(struct pollfd*, nfds_t, int)>(nextPoll, "poll")(fds, numFds, timeout);
+    }
+
+    int select(int numFds, fd_set* readFds, fd_set* writeFds, fd_set* exceptFds, struct timeval* timeout)
+    {
+        checkBlocking("select");
+        return findNext<int (*)(int, fd_set*, fd_set*, fd_set*, struct timeval*)>(nextSelect, "select")(numFds, readFds, writeFds, exceptFds, timeout);
+    }
+}
+
+#endif // __GLIBC__
+
+#endif // MYPLUGIN_RT_SANITIZER
@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+    Purpose: Real-Time Safety Sanitizer Header File
+
+    Debug/test build mode that catches audio-thread work which can block:
+    heap allocation and deallocation, mutex locks and blocking system calls.
+
+    Enable it by defining MYPLUGIN_RT_SANITIZER=1 in the preprocessor definitions
+    of a debug or test build. Code inside MYPLUGIN_REALTIME_SCOPE (processBlock)
+    is then checked, and every violation is either recorded or reported with a
+    stack trace followed by abort().
+
+    operator new/delete are replaced on every platform. malloc/free, mutex locks
+    and blocking calls are interposed on Linux with glibc only. Interposition needs
+    the sanitizer to be linked into the executable (Standalone build or test runner);
+    a plugin loaded by a host cannot replace the host's symbols.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#ifndef MYPLUGIN_RT_SANITIZER
+ #define MYPLUGIN_RT_SANITIZER 0
+#endif
+
+
+//==============================================================================
+/*
+Class: RealtimeSanitizer
+       Tracks, per thread, whether the thread is inside a real-time scope and
+       collects violations raised by the interposed functions
+       Recording a violation never allocates
+*/
+class RealtimeSanitizer
+{
+public:
+    enum class ViolationKind
+    {
+        Allocation = 0,
+        Deallocation,
+        MutexLock,
+        BlockingCall
+    };
+
+    // Record: keep violations for later inspection with getNumViolations/getViolation
+    // Abort: print the violation and a stack trace, then abort()
+    enum class Mode
+    {
+        Record = 0,
+        Abort
+    };
+
+    struct Violation
+    {
+        ViolationKind kind = ViolationKind::Allocation;
+        // Name of the intercepted function, always a string literal
+        const char* function = "";
+    };
+
+    // Marks the lifetime of this object on the calling thread as real-time
+    // Scopes may be nested
+    class ScopedRealtimeContext
+    {
+    public:
+        ScopedRealtimeContext();
+        ~ScopedRealtimeContext();
+
+        ScopedRealtimeContext(const ScopedRealtimeContext&) = delete;
+        ScopedRealtimeContext& operator=(const ScopedRealtimeContext&) = delete;
+    };
+
+    static void setMode(Mode newMode);
+    static Mode getMode();
+
+    // Returns true if the calling thread is inside a real-time scope
+    static bool isInRealtimeScope();
+
+    // Called by the interposed functions, reports a violation if the calling thread is real-time
+    static void checkRealtime(ViolationKind kind, const char* function);
+
+    // Total number of violations since the last clearViolations
+    // Only the first maxRecordedViolations are kept for getViolation
+    static int getNumViolations();
+    static Violation getViolation(int index);
+    static void clearViolations();
+
+    static constexpr int maxRecordedViolations = 64;
+
+    // Returns a readable name for a violation kind
+    static const char* getKindName(ViolationKind kind);
+};
+
+#if MYPLUGIN_RT_SANITIZER
+ #define MYPLUGIN_REALTIME_SCOPE RealtimeSanitizer::ScopedRealtimeContext realtimeSanitizerScope;
+#else
+ #define MYPLUGIN_REALTIME_SCOPE
+#endif
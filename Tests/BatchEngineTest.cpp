@@ -0,0 +1,192 @@
+/*
+  ==============================================================================
+    Purpose: Batch Engine Test and Throughput Benchmark
+
+    Checks the batch engine's output for several streams against one processor
+    per stream with the same settings, then measures and prints its throughput
+    per core next to that of the processor.
+
+    The engine's LFO is not bit-compatible with the processor's (see
+    FlangerBatchEngine.h), so the comparison uses LFO rates with a whole number of
+    samples per period and a short run, and allows for the phasor's rounding drift.
+
+    Build as a JUCE console application together with ../Source/PluginProcessor.cpp,
+    ../Source/PluginEditor.cpp, ../Source/RealtimeSanitizer.cpp and
+    ../Source/FlangerBatchEngine.cpp, with optimisation enabled for meaningful numbers.
+    Exits with a non-zero code on failure.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/PluginProcessor.h"
+#include "../Source/FlangerBatchEngine.h"
+
+#include <iostream>
+
+namespace
+{
+    int numFailures = 0;
+
+    void expect(bool condition, const char* description)
+    {
+        if (!condition)
+        {
+            std::cerr << "FAILED: " << description << std::endl;
+            numFailures++;
+        }
+    }
+
+    // Settings for stream stream of a test, with rates that have a whole number of samples per period
+    FlangerSettings getTestSettings(int stream)
+    {
+        const float rates[] = { 0.75f, 1.0f, 1.5f, 2.0f, 3.0f, 4.0f, 6.0f, 8.0f };
+
+        FlangerSettings settings;
+        settings.f_ratio = 1.0f + 0.007f * (float)(stream % 8 + 1);
+        settings.lfoFrequency = rates[stream % 8];
+        settings.phaseOffset = (float)(stream % 4) * (float)M_PI / 4.0f;
+        settings.delayMinimum = 20 + 37 * stream;
+        settings.delayGain = 0.3f + 0.05f * (float)(stream % 8);
+        settings.regenGain = 0.1f * (float)(stream % 6);
+        return settings;
+    }
+
+    // Apply the same settings to a processor, in the processor's parameter units
+    void applyTestSettings(MyPlugInAudioProcessor& processor, const FlangerSettings& settings)
+    {
+        processor.setParameterAsync(ParameterId::Depth, settings.f_ratio);
+        processor.setParameterAsync(ParameterId::Rate, settings.lfoFrequency);
+        processor.setParameterAsync(ParameterId::PhaseOffset, settings.phaseOffset * 180.0f / (float)M_PI);
+        processor.setParameterAsync(ParameterId::Delay, (float)settings.delayMinimum);
+        processor.setParameterAsync(ParameterId::DelayGain, settings.delayGain);
+        processor.setParameterAsync(ParameterId::RegenGain, settings.regenGain);
+    }
+
+    // The engine's output matches one processor per stream
+    void testMatchesProcessor()
+    {
+        const int numStreams = 8;
+        const int blockSize = 256;
+        // About 0.5 s at 48 kHz
+        const int numBlocks = 94;
+        // The phasor drift stays below about 1e-3 over this run, depending on the compiler's use of FMA
+        const float tolerance = 2.0e-3f;
+
+        FlangerBatchEngine engine;
+        engine.prepare(numStreams, 2, 48000.0);
+
+        MyPlugInAudioProcessor processors[numStreams];
+        juce::AudioBuffer<float> engineBuffers[numStreams];
+        juce::AudioBuffer<float> processorBuffers[numStreams];
+        FlangerStream streams[numStreams];
+
+        for (int stream = 0; stream < numStreams; stream++)
+        {
+            engine.setStreamSettings(stream, getTestSettings(stream));
+            processors[stream].prepareToPlay(48000.0, blockSize);
+            applyTestSettings(processors[stream], getTestSettings(stream));
+
+            engineBuffers[stream].setSize(2, blockSize);
+            processorBuffers[stream].setSize(2, blockSize);
+            streams[stream] = { engineBuffers[stream].getArrayOfWritePointers(), blockSize };
+        }
+
+        juce::Random random(484);
+        juce::MidiBuffer midiMessages;
+        float maxDifference = 0.0f;
+
+        for (int block = 0; block < numBlocks; block++)
+        {
+            for (int stream = 0; stream < numStreams; stream++)
+            {
+                for (int channel = 0; channel < 2; channel++)
+                {
+                    for (int index = 0; index < blockSize; index++)
+                    {
+                        float sample = random.nextFloat() - 0.5f;
+                        engineBuffers[stream].setSample(channel, index, sample);
+                        processorBuffers[stream].setSample(channel, index, sample);
+                    }
+                }
+
+                processors[stream].processBlock(processorBuffers[stream], midiMessages);
+            }
+
+            engine.processBatch(streams, numStreams);
+
+            for (int stream = 0; stream < numStreams; stream++)
+                for (int channel = 0; channel < 2; channel++)
+                    for (int index = 0; index < blockSize; index++)
+                        maxDifference = juce::jmax(maxDifference, std::abs(engineBuffers[stream].getSample(channel, index)
+                                                                           - processorBuffers[stream].getSample(channel, index)));
+        }
+
+        std::cout << "Largest difference from the processor: " << maxDifference << std::endl;
+        expect(maxDifference < tolerance, "batch engine output matches the processor");
+    }
+
+    // Measure and print the engine's throughput per core, and the processor's for comparison
+    void benchmarkThroughput()
+    {
+        const int numStreams = 256;
+        const int blockSize = 256;
+        // About 2 s of audio per stream at 48 kHz
+        const int numBlocks = 375;
+
+        FlangerBatchEngine engine;
+        engine.prepare(numStreams, 2, 48000.0);
+        for (int stream = 0; stream < numStreams; stream++)
+            engine.setStreamSettings(stream, getTestSettings(stream));
+
+        std::vector<juce::AudioBuffer<float>> buffers((size_t)numStreams, juce::AudioBuffer<float>(2, blockSize));
+        std::vector<FlangerStream> streams((size_t)numStreams);
+        juce::Random random(484);
+        for (int stream = 0; stream < numStreams; stream++)
+        {
+            for (int channel = 0; channel < 2; channel++)
+                for (int index = 0; index < blockSize; index++)
+                    buffers[(size_t)stream].setSample(channel, index, random.nextFloat() - 0.5f);
+
+            streams[(size_t)stream] = { buffers[(size_t)stream].getArrayOfWritePointers(), blockSize };
+        }
+
+        engine.resetStatistics();
+        for (int block = 0; block < numBlocks; block++)
+            engine.processBatch(streams.data(), numStreams);
+
+        // The processor on the same amount of audio for one stream
+        MyPlugInAudioProcessor processor;
+        processor.prepareToPlay(48000.0, blockSize);
+        applyTestSettings(processor, getTestSettings(0));
+        juce::MidiBuffer midiMessages;
+
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        for (int block = 0; block < numBlocks; block++)
+            processor.processBlock(buffers[0], midiMessages);
+        double processorSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+        double processorFramesPerSecond = (double)numBlocks * (double)blockSize * 2.0 / processorSeconds;
+
+        std::cout << "Batch engine, " << numStreams << " stereo streams: "
+                  << engine.getFramesPerSecondPerCore() / 1.0e6 << " M lane-frames/s per core, "
+                  << engine.getRealtimeStreamsPerCore() << " real-time streams per core" << std::endl;
+        std::cout << "Processor, one stereo stream: "
+                  << processorFramesPerSecond / 1.0e6 << " M lane-frames/s per core, "
+                  << processorFramesPerSecond / (48000.0 * 2.0) << " real-time streams per core" << std::endl;
+
+        expect(engine.getFramesPerSecondPerCore() > 0.0, "batch engine throughput is measured");
+        expect(engine.getRealtimeStreamsPerCore() > 0.0, "batch engine real-time stream count is reported");
+    }
+}
+
+//==============================================================================
+int main()
+{
+    testMatchesProcessor();
+    benchmarkThroughput();
+
+    if (numFailures == 0)
+        std::cout << "All batch engine tests passed" << std::endl;
+
+    return numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+    Purpose: Cascade LFO Sync Test
+
+    With a rate spread of 1, every extra cascade stage shares the processor's
+    LFO values. Checks that the stage LFOs stay in sync with the processor's
+    LFOs while parameters are automated densely, both through timestamped
+    events and through setParameterAsync.
+
+    Build as a JUCE console application together with ../Source/PluginProcessor.cpp,
+    ../Source/PluginEditor.cpp and ../Source/RealtimeSanitizer.cpp.
+    Exits with a non-zero code on failure.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/PluginProcessor.h"
+#include "../Source/FlangerCascade.h"
+
+#include <iostream>
+
+namespace
+{
+    int numFailures = 0;
+
+    void expect(bool condition, const char* description)
+    {
+        if (!condition)
+        {
+            std::cerr << "FAILED: " << description << std::endl;
+            numFailures++;
+        }
+    }
+
+    // Returns true if every extra stage LFO is in sync with the processor's LFO of its channel
+    bool stagesInSync(MyPlugInAudioProcessor& processor)
+    {
+        FlangerCascade& cascade = processor.getCascade();
+
+        for (int stage = 0; stage < cascade.getNumExtraStages(); stage++)
+        {
+            if (!cascade.getStageLFO(stage, 0).isInSyncWith(processor.left_LFO1)
+                || !cascade.getStageLFO(stage, 1).isInSyncWith(processor.right_LFO1))
+                return false;
+        }
+
+        return true;
+    }
+
+    // Automate one parameter on every sample for several LFO periods
+    void testAutomation(ParameterId id, float minimum, float maximum, const char* description)
+    {
+        const int blockSize = 32;
+        // About 3 s at 48 kHz
+        const int numBlocks = 4500;
+
+        MyPlugInAudioProcessor processor;
+        processor.prepareToPlay(48000.0, blockSize);
+        processor.setParameterAsync(ParameterId::Delay, 300.0f);
+        processor.setParameterAsync(ParameterId::CascadeRateSpread, 1.0f);
+        processor.setParameterAsync(ParameterId::CascadeStages, 4.0f);
+
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::MidiBuffer midiMessages;
+        juce::Random random(484);
+        int blocksOutOfSync = 0;
+
+        for (int block = 0; block < numBlocks; block++)
+        {
+            for (int channel = 0; channel < 2; channel++)
+                for (int index = 0; index < blockSize; index++)
+                    buffer.setSample(channel, index, random.nextFloat() - 0.5f);
+
+            for (int offset = 0; offset < blockSize; offset++)
+                processor.queueParameterEvent(offset, id, minimum + (maximum - minimum) * random.nextFloat());
+
+            // The same parameter from another thread now and then
+            if (block % 100 == 0)
+                processor.setParameterAsync(id, minimum + (maximum - minimum) * random.nextFloat());
+
+            processor.processBlock(buffer, midiMessages);
+
+            if (!stagesInSync(processor))
+                blocksOutOfSync++;
+        }
+
+        if (blocksOutOfSync > 0)
+            std::cerr << "  " << blocksOutOfSync << " of " << numBlocks << " blocks out of sync" << std::endl;
+
+        expect(blocksOutOfSync == 0, description);
+    }
+}
+
+//==============================================================================
+int main()
+{
+    testAutomation(ParameterId::RegenGain, 0.0f, 0.95f, "stage LFOs stay in sync under regeneration gain automation");
+    testAutomation(ParameterId::DelayGain, 0.0f, 1.0f, "stage LFOs stay in sync under delay gain automation");
+    testAutomation(ParameterId::Depth, 1.0f, 1.059f, "stage LFOs stay in sync under depth automation");
+    testAutomation(ParameterId::Delay, 1.0f, 1488.0f, "stage LFOs stay in sync under delay automation");
+    testAutomation(ParameterId::PhaseOffset, 0.0f, 180.0f, "stage LFOs stay in sync under phase offset automation");
+    testAutomation(ParameterId::Rate, 0.1f, 9.0f, "stage LFOs stay in sync under rate automation");
+
+    if (numFailures == 0)
+        std::cout << "All cascade sync tests passed" << std::endl;
+
+    return numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+    Purpose: Dual-Mono Test
+
+    Feeds the processor stereo input that is identical on both channels, then
+    different, then identical again, and checks that every output sample matches
+    per-channel reference processors bit for bit. Each reference processor gets
+    the channel under test plus unrelated noise on the other channel, so it never
+    enters dual-mono mode. Also checks that dual-mono mode is entered and left.
+
+    Build as a JUCE console application together with ../Source/PluginProcessor.cpp,
+    ../Source/PluginEditor.cpp and ../Source/RealtimeSanitizer.cpp.
+    Exits with a non-zero code on failure.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/PluginProcessor.h"
+
+#include <iostream>
+
+namespace
+{
+    int numFailures = 0;
+
+    void expect(bool condition, const char* description)
+    {
+        if (!condition)
+        {
+            std::cerr << "FAILED: " << description << std::endl;
+            numFailures++;
+        }
+    }
+
+    void setParameters(MyPlugInAudioProcessor& processor, float delay)
+    {
+        processor.setParameterAsync(ParameterId::Delay, delay);
+        processor.setParameterAsync(ParameterId::Depth, 1.03f);
+        processor.setParameterAsync(ParameterId::Rate, 0.7f);
+        processor.setParameterAsync(ParameterId::RegenGain, 0.5f);
+    }
+
+    // Identical, different and identical input again, each long enough to fill the delay line
+    void testTransitions()
+    {
+        const int blockSizes[] = { 512, 1, 7, 33, 100, 64, 256 };
+        const int segmentFrames = 2 * 48000;
+        const int numSegments = 3;
+
+        MyPlugInAudioProcessor processor;
+        // references[channel] reproduces output channel channel of processor without dual-mono mode
+        MyPlugInAudioProcessor references[2];
+
+        processor.prepareToPlay(48000.0, 512);
+        setParameters(processor, 300.0f);
+        for (MyPlugInAudioProcessor& reference : references)
+        {
+            reference.prepareToPlay(48000.0, 512);
+            setParameters(reference, 300.0f);
+        }
+
+        juce::Random random(484);
+        juce::MidiBuffer midiMessages;
+        int dualMonoBlocks[numSegments] = { 0, 0, 0 };
+        int mismatchedSamples = 0;
+        int block = 0;
+
+        for (int segment = 0; segment < numSegments; segment++)
+        {
+            bool identical = segment != 1;
+
+            for (int frame = 0; frame < segmentFrames; block++)
+            {
+                int blockSize = juce::jmin(blockSizes[block % 7], segmentFrames - frame);
+                juce::AudioBuffer<float> buffer(2, blockSize);
+                juce::AudioBuffer<float> referenceBuffers[2] = { juce::AudioBuffer<float>(2, blockSize), juce::AudioBuffer<float>(2, blockSize) };
+
+                for (int index = 0; index < blockSize; index++)
+                {
+                    float left = random.nextFloat() - 0.5f;
+                    float right = identical ? left : random.nextFloat() - 0.5f;
+                    buffer.setSample(0, index, left);
+                    buffer.setSample(1, index, right);
+
+                    // The channel under test, with noise on the other channel
+                    referenceBuffers[0].setSample(0, index, left);
+                    referenceBuffers[0].setSample(1, index, random.nextFloat() - 0.5f);
+                    referenceBuffers[1].setSample(0, index, random.nextFloat() - 0.5f);
+                    referenceBuffers[1].setSample(1, index, right);
+                }
+
+                // A settings change while the channels are mirrored
+                if (segment == 0 && frame >= segmentFrames / 2 && frame < segmentFrames / 2 + blockSize)
+                {
+                    setParameters(processor, 450.0f);
+                    for (MyPlugInAudioProcessor& reference : references)
+                        setParameters(reference, 450.0f);
+                }
+
+                processor.processBlock(buffer, midiMessages);
+                for (int channel = 0; channel < 2; channel++)
+                    references[channel].processBlock(referenceBuffers[channel], midiMessages);
+
+                if (processor.wasLastSubBlockDualMono())
+                    dualMonoBlocks[segment]++;
+
+                for (int channel = 0; channel < 2; channel++)
+                    for (int index = 0; index < blockSize; index++)
+                        if (buffer.getSample(channel, index) != referenceBuffers[channel].getSample(channel, index))
+                            mismatchedSamples++;
+
+                frame += blockSize;
+            }
+        }
+
+        if (mismatchedSamples > 0)
+            std::cerr << "  " << mismatchedSamples << " output samples differ from the references" << std::endl;
+
+        expect(mismatchedSamples == 0, "dual-mono output matches per-channel processing bit for bit");
+        expect(dualMonoBlocks[0] > 0, "identical input enters dual-mono mode");
+        expect(dualMonoBlocks[1] == 0, "different input leaves dual-mono mode");
+        expect(dualMonoBlocks[2] > 0, "identical input enters dual-mono mode again");
+    }
+}
+
+//==============================================================================
+int main()
+{
+    testTransitions();
+
+    if (numFailures == 0)
+        std::cout << "All dual-mono tests passed" << std::endl;
+
+    return numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+    Purpose: Host Parameter Test
+
+    Checks that the processor registers one host parameter per ParameterId with
+    the processor's ranges, and that a change to a host parameter, as a host
+    makes for automation, reaches the processor by the next processBlock.
+
+    Build as a JUCE console application together with ../Source/PluginProcessor.cpp,
+    ../Source/PluginEditor.cpp and ../Source/RealtimeSanitizer.cpp.
+    Exits with a non-zero code on failure.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/PluginProcessor.h"
+
+#include <iostream>
+
+namespace
+{
+    int numFailures = 0;
+
+    void expect(bool condition, const char* description)
+    {
+        if (!condition)
+        {
+            std::cerr << "FAILED: " << description << std::endl;
+            numFailures++;
+        }
+    }
+
+    void testHostParameters()
+    {
+        MyPlugInAudioProcessor processor;
+        processor.prepareToPlay(48000.0, 64);
+
+        juce::AudioBuffer<float> buffer(2, 64);
+        juce::MidiBuffer midiMessages;
+
+        const int numParameters = (int)ParameterId::NumParameters;
+        expect((int)processor.getParameters().size() == numParameters, "one host parameter per ParameterId");
+        if ((int)processor.getParameters().size() != numParameters)
+            return;
+
+        for (int index = 0; index < numParameters; index++)
+        {
+            ParameterId id = (ParameterId)index;
+            auto* parameter = dynamic_cast<juce::AudioParameterFloat*>(processor.getParameters()[index]);
+            expect(parameter != nullptr, "host parameters are float parameters");
+            if (parameter == nullptr)
+                continue;
+
+            juce::Range<float> range = MyPlugInAudioProcessor::getParameterRange(id);
+            expect(parameter->convertFrom0to1(0.0f) == range.getStart() && parameter->convertFrom0to1(1.0f) == range.getEnd(),
+                   "host parameter ranges match the processor's");
+            expect(std::abs(parameter->get() - processor.getParameterValue(id)) < 1.0e-4f,
+                   "host parameters start from the processor's values");
+
+            // A host automation change, applied at the start of the next block
+            parameter->setValueNotifyingHost(1.0f);
+            processor.processBlock(buffer, midiMessages);
+            expect(processor.getParameterValue(id) == range.getEnd(), "host parameter changes reach the processor");
+        }
+    }
+}
+
+//==============================================================================
+int main()
+{
+    testHostParameters();
+
+    if (numFailures == 0)
+        std::cout << "All host parameter tests passed" << std::endl;
+
+    return numFailures == 0 ? 0 : 1;
+}
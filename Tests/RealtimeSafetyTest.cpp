@@ -0,0 +1,152 @@
+/*
+  ==============================================================================
+    Purpose: Real-Time Safety Test
+
+    Drives the processor through parameter changes, timestamped events, MIDI CC,
+    sample-rate changes, preset loads, offline/real-time switches and block sizes
+    from 1 to 8192 with the real-time safety sanitizer active, and fails if
+    processBlock allocates, locks or blocks.
+
+    Build as a JUCE console application with MYPLUGIN_RT_SANITIZER=1 together with
+    ../Source/PluginProcessor.cpp, ../Source/PluginEditor.cpp and
+    ../Source/RealtimeSanitizer.cpp. Exits with a non-zero code on failure.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/PluginProcessor.h"
+#include "../Source/RealtimeSanitizer.h"
+
+#include <iostream>
+
+#if ! MYPLUGIN_RT_SANITIZER
+ #error "Build this test with MYPLUGIN_RT_SANITIZER=1"
+#endif
+
+namespace
+{
+    int numFailures = 0;
+
+    // Keeps the deliberate allocation below from being optimised away
+    void* volatile allocationSink = nullptr;
+
+    void expect(bool condition, const char* description)
+    {
+        if (!condition)
+        {
+            std::cerr << "FAILED: " << description << std::endl;
+            numFailures++;
+        }
+    }
+
+    void printViolations()
+    {
+        int numRecorded = juce::jmin(RealtimeSanitizer::getNumViolations(), (int)RealtimeSanitizer::maxRecordedViolations);
+        for (int index = 0; index < numRecorded; index++)
+        {
+            RealtimeSanitizer::Violation violation = RealtimeSanitizer::getViolation(index);
+            std::cerr << "  " << RealtimeSanitizer::getKindName(violation.kind) << " in " << violation.function << std::endl;
+        }
+    }
+
+    // Fill every channel with a deterministic test signal
+    void fillBuffer(juce::AudioBuffer<float>& buffer, juce::Random& random)
+    {
+        for (int channel = 0; channel < buffer.getNumChannels(); channel++)
+        {
+            float* data = buffer.getWritePointer(channel);
+            for (int index = 0; index < buffer.getNumSamples(); index++)
+                data[index] = random.nextFloat() - 0.5f;
+        }
+    }
+
+    // processBlock with every kind of parameter change, for every block size
+    void testProcessBlock()
+    {
+        const double sampleRates[] = { 44100.0, 48000.0, 96000.0 };
+        const int blockSizes[] = { 1, 7, 31, 32, 33, 64, 100, 512, 1024, 8192 };
+
+        MyPlugInAudioProcessor processor;
+        juce::Random random(484);
+        RealtimeSanitizer::clearViolations();
+
+        for (int round = 0; round < 12; round++)
+        {
+            // Sample-rate change and preset load happen outside processBlock, as in a host
+            processor.prepareToPlay(sampleRates[round % 3], 512);
+            juce::MemoryBlock state;
+            processor.getStateInformation(state);
+            processor.setStateInformation(state.getData(), (int)state.getSize());
+            processor.setNonRealtime(round % 4 == 3);
+
+            for (int blockSize : blockSizes)
+            {
+                juce::AudioBuffer<float> buffer(2, blockSize);
+                juce::MidiBuffer midiMessages;
+
+                for (int block = 0; block < 8; block++)
+                {
+                    fillBuffer(buffer, random);
+
+                    // Changes from another thread's point of view, applied at the block start
+                    processor.setParameterAsync(ParameterId::Depth, 1.0f + 0.059f * random.nextFloat());
+                    processor.setParameterAsync(ParameterId::Rate, 0.1f + 8.9f * random.nextFloat());
+                    processor.setParameterAsync(ParameterId::Delay, (float)(1 + random.nextInt(1488)));
+                    processor.setParameterAsync(ParameterId::PhaseOffset, (float)random.nextInt(181));
+                    processor.setParameterAsync(ParameterId::CascadeStages, (float)(1 + (round + block) % 4));
+                    processor.setParameterAsync(ParameterId::CascadeRateSpread, 1.0f + random.nextFloat());
+
+                    // Timestamped changes within the block
+                    processor.queueParameterEvent(random.nextInt(blockSize), ParameterId::DelayGain, random.nextFloat());
+                    processor.queueParameterEvent(random.nextInt(blockSize), ParameterId::RegenGain, 0.95f * random.nextFloat());
+
+                    // Mapped MIDI controllers within the block
+                    midiMessages.clear();
+                    midiMessages.addEvent(juce::MidiMessage::controllerEvent(1, 1, random.nextInt(128)), random.nextInt(blockSize));
+                    midiMessages.addEvent(juce::MidiMessage::controllerEvent(1, 20, random.nextInt(128)), random.nextInt(blockSize));
+                    midiMessages.addEvent(juce::MidiMessage::controllerEvent(1, 21, random.nextInt(128)), random.nextInt(blockSize));
+
+                    processor.processBlock(buffer, midiMessages);
+                }
+            }
+        }
+
+        expect(RealtimeSanitizer::getNumViolations() == 0, "processBlock is real-time safe");
+        printViolations();
+    }
+
+    // The sanitizer must catch an allocation inside a real-time scope
+    void testAllocationIsRecorded()
+    {
+        RealtimeSanitizer::clearViolations();
+
+        {
+            MYPLUGIN_REALTIME_SCOPE
+            float* allocation = new float[16];
+            allocationSink = allocation;
+            delete[] allocation;
+        }
+
+        expect(RealtimeSanitizer::getNumViolations() >= 1, "an allocation in a real-time scope is recorded");
+        expect(RealtimeSanitizer::getNumViolations() >= 1
+               && RealtimeSanitizer::getViolation(0).kind == RealtimeSanitizer::ViolationKind::Allocation,
+               "the first recorded violation is the allocation");
+
+        RealtimeSanitizer::clearViolations();
+    }
+}
+
+//==============================================================================
+int main()
+{
+    RealtimeSanitizer::setMode(RealtimeSanitizer::Mode::Record);
+
+    testProcessBlock();
+    testAllocationIsRecorded();
+
+    if (numFailures == 0)
+        std::cout << "All real-time safety tests passed" << std::endl;
+
+    return numFailures == 0 ? 0 : 1;
+}